@@ -0,0 +1,256 @@
+/**********************************************************************
+
+   File          : cmsc312-p2-2q.c
+
+   Description   : This is 2Q (Johnson and Shasha).  A page coming in
+                   for the first time waits on a short FIFO, a1in; when
+                   it leaves, only its name is kept on a1out.  A page
+                   that faults again while on a1out has shown it is
+                   reused and goes to the LRU list am.  Pages touched by
+                   a scan pass through a1in without disturbing am
+                   (see .h for applications)
+
+***********************************************************************/
+/**********************************************************************
+Copyright (c) 2016 The Pennsylvania State University
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of The Pennsylvania State University nor the names of its contributors may be used to endorse or promote products derived from this softwiare without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* Include Files */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <assert.h>
+
+/* Project Include Files */
+#include "cmsc312-p2.h"
+
+/* Definitions */
+
+typedef struct twoq {
+  qlist_t a1in;               /* resident frames, FIFO: head newest */
+  qlist_t am;                 /* resident frames, LRU: head most recent */
+  qlist_t a1out;              /* ghosts of pages that left a1in */
+  qdir_t dir;
+  int *pid;                   /* process owning the page in each frame */
+  int shared;                 /* the frame arrays are the machine's first state's */
+} twoq_t;
+
+/* each simulated machine keeps its own queues as sim->repl */
+
+/* target length of a1in, a quarter of the frames managed, and the
+   length of a1out, half as many pages (see local_frames) */
+#define TWOQ_KIN( c )   ((( c ) / 4 > 1 ) ? ( c ) / 4 : 1 )
+#define TWOQ_KOUT( c )  ((( c ) / 2 > 1 ) ? ( c ) / 2 : 1 )
+
+
+/**********************************************************************
+
+    Function    : init_2q
+    Description : initialize empty queues sized by the frame count (a
+                  process's state under local replacement shares the
+                  frame arrays of the machine's, and a1out's room grows
+                  as pages join it)
+    Inputs      : tr - input trace
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int init_2q( trace_t *tr )
+{
+  twoq_t *model = (twoq_t *)sim->repl;
+  twoq_t *q = (twoq_t *)calloc( 1, sizeof(twoq_t) );
+  int c = sim->frames, n;
+
+  if (( sim->repl = q ) == NULL )
+    return -1;
+
+  n = TWOQ_KOUT( c );
+
+  if ( model ) {
+    q->shared = 1;
+    q->pid = model->pid;
+    qlist_share( &q->a1in, &model->a1in );
+    qlist_share( &q->am, &model->am );
+    n = ( n > QDIR_MIN ) ? QDIR_MIN : n;
+  }
+  else {
+    q->pid = (int *)calloc( c, sizeof(int) );
+    if (( q->pid == NULL ) || qlist_init( &q->a1in, c ) || qlist_init( &q->am, c ))
+      return -1;
+  }
+
+  if ( qdir_init( &q->dir, n ) || qlist_init( &q->a1out, n ))
+    return -1;
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : exit_2q
+    Description : free the queues
+    Inputs      : none
+    Outputs     : none
+
+***********************************************************************/
+
+void exit_2q( void )
+{
+  twoq_t *q = (twoq_t *)sim->repl;
+
+  if ( !q->shared ) {
+    qlist_free( &q->a1in );
+    qlist_free( &q->am );
+    free( q->pid );
+  }
+  qlist_free( &q->a1out );
+  qdir_free( &q->dir );
+  free( q );
+}
+
+
+/**********************************************************************
+
+    Function    : replace_2q
+    Description : the oldest page of a1in once it is over its target
+                  (remembering it on a1out), else the LRU page of am;
+                  both lengths follow the frames the state manages
+    Inputs      : pid - process id of victim frame 
+                  victim - frame assignment 
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int replace_2q( int *pid, frame_t **victim )
+{
+  twoq_t *q = (twoq_t *)sim->repl;
+  qlist_t *lists[1] = { &q->a1out };
+  int c = local_frames( ), frame;
+
+  if (( q->a1in.len > TWOQ_KIN( c )) || ( q->am.len == 0 )) {
+    if (( frame = q->a1in.tail ) == QLIST_NONE )
+      return -1;
+    qlist_remove( &q->a1in, frame );
+
+    /* a quota that shrank leaves a1out over its length for a while */
+    while ( q->a1out.len >= TWOQ_KOUT( c ))
+      qdir_drop( &q->dir, &q->a1out );
+    if ( qdir_room( &q->dir, lists, 1 ))
+      return -1;
+    qdir_ghost( &q->dir, &q->a1out, q->pid[frame], sim->physical_mem[frame].page );
+  }
+  else {
+    frame = q->am.tail;
+    qlist_remove( &q->am, frame );
+  }
+
+  *victim = &(sim->physical_mem[frame]);
+  *pid = q->pid[frame];
+
+  EVENT( LOG_FAULTS, EV_VICTIM, *pid, sim->physical_mem[frame].page, frame, 0 );
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : update_2q
+    Description : a page was loaded into a frame: am if it was on a1out,
+                  else a1in
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int update_2q( int pid, frame_t *f )
+{
+  twoq_t *q = (twoq_t *)sim->repl;
+  int e = qdir_find( &q->dir, pid, f->page );
+
+  q->pid[f->number] = pid;
+
+  if ( e == QLIST_NONE ) {
+    qlist_push( &q->a1in, f->number );
+    return 0;
+  }
+
+  qlist_remove( &q->a1out, e );
+  qdir_del( &q->dir, e );
+  qlist_push( &q->am, f->number );
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : ref_2q
+    Description : a resident page was referenced: to the head of am if
+                  it is there (a1in is left in order)
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int ref_2q( int pid, frame_t *f )
+{
+  twoq_t *q = (twoq_t *)sim->repl;
+
+  if ( qlist_on( &q->am, f->number )) {
+    qlist_remove( &q->am, f->number );
+    qlist_push( &q->am, f->number );
+  }
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : release_2q
+    Description : the page in frame f was swapped out with its process:
+                  it leaves a1in or am
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int release_2q( int pid, frame_t *f )
+{
+  twoq_t *q = (twoq_t *)sim->repl;
+
+  if ( qlist_on( &q->a1in, f->number ))
+    qlist_remove( &q->a1in, f->number );
+  else if ( qlist_on( &q->am, f->number ))
+    qlist_remove( &q->am, f->number );
+
+  return 0;
+}
@@ -0,0 +1,243 @@
+/**********************************************************************
+
+   File          : cmsc312-p2-ahead.c
+
+   Description   : Readahead.  Each process's faults are watched for a
+                   stream: two faults the same stride apart (one page
+                   for a sequential sweep, more for a strided one) start
+                   it, and the next window pages along the stride are
+                   read in with the fault.  A fault just past the
+                   window continues the stream and doubles the window,
+                   up to readahead_max pages (and a quarter of the frames);
+                   a page read ahead but evicted before its first
+                   reference halves it.  Pages read ahead take free
+                   frames, or else frames page replacement gives up,
+                   and come in clean and unreferenced, so policies that
+                   rank by use see them as low value
+                   (see .h for applications)
+
+***********************************************************************/
+/**********************************************************************
+Copyright (c) 2016 The Pennsylvania State University
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of The Pennsylvania State University nor the names of its contributors may be used to endorse or promote products derived from this softwiare without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* Include Files */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <assert.h>
+
+/* Project Include Files */
+#include "cmsc312-p2.h"
+
+/* Definitions */
+#define RA_SHARE      4             /* a window is at most frames / RA_SHARE */
+
+
+/**********************************************************************
+
+    Function    : ra_init
+    Description : start watching fault streams on the current machine
+    Inputs      : none
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int ra_init( void )
+{
+  ra_state_t *r = (ra_state_t *)calloc( 1, sizeof(ra_state_t) );
+
+  if (( sim->ra = r ) == NULL )
+    return -1;
+
+  r->stream = (ra_stream_t *)calloc( max_processes, sizeof(ra_stream_t) );
+  r->ahead = (uint64_t *)calloc( BITMAP_WORDS( sim->frames ), sizeof(uint64_t) );
+  r->max = ( readahead_max < sim->frames / RA_SHARE ) ? readahead_max : sim->frames / RA_SHARE;
+  if ( r->max < 1 )
+    r->max = 1;
+
+  return (( r->stream == NULL ) || ( r->ahead == NULL )) ? -1 : 0;
+}
+
+
+/**********************************************************************
+
+    Function    : ra_exit
+    Description : free the readahead state
+    Inputs      : none
+    Outputs     : none
+
+***********************************************************************/
+
+void ra_exit( void )
+{
+  if ( sim->ra == NULL )
+    return;
+
+  free( sim->ra->stream );
+  free( sim->ra->ahead );
+  free( sim->ra );
+  sim->ra = NULL;
+}
+
+
+/**********************************************************************
+
+    Function    : ra_fault
+    Description : a process faulted on a page: follow its stream, and
+                  read ahead along it if the fault continues one
+    Inputs      : pid - process id
+                  page - page faulted on
+                  mech - replacement mechanism
+    Outputs     : pages read ahead, or -1 on failure
+
+***********************************************************************/
+
+int ra_fault( int pid, vpn_t page, int mech )
+{
+  ra_state_t *r = sim->ra;
+  ra_stream_t *s = &r->stream[pid];
+  vpn_t pages = ( va_bits - page_shift < 64 ) ? (vpn_t)1 << ( va_bits - page_shift ) : 0;
+  vpn_t next;
+  int i, n = 0, rc;
+
+  if ( s->window && ( page == s->next )) {
+    /* just past the window: the stream goes on, and reads further */
+    s->window = ( 2 * s->window < r->max ) ? 2 * s->window : r->max;
+  }
+  else if ( s->stride && ( page == s->last + s->stride )) {
+    s->window = ( RA_MIN < r->max ) ? RA_MIN : r->max;
+    sim->ra_streams++;
+  }
+  else {
+    /* no stream (or it broke): remember the stride, read nothing */
+    s->stride = (int64_t)( page - s->last );
+    s->last = page;
+    s->window = 0;
+    return 0;
+  }
+
+  s->last = page;
+  s->next = page + ( s->window + 1 ) * s->stride;
+  sim->ra_windows++;
+
+  for ( i = 1; i <= s->window; i++ ) {
+    next = page + i * s->stride;
+
+    /* the stream runs off the address space */
+    if (( s->stride > 0 ) ? (( next < page ) || ( pages && ( next >= pages ))) : ( next > page ))
+      break;
+
+    if (( rc = pt_prefetch_page( pid, next, mech )) < 0 )
+      return -1;
+    if ( rc ) {
+      BITMAP_SET( r->ahead, pt_lookup( pid, next, 0, NULL )->frame );
+      n++;
+    }
+  }
+
+  sim->ra_pages += n;
+  return n;
+}
+
+
+/**********************************************************************
+
+    Function    : ra_ref
+    Description : a frame's page was referenced: a page read ahead has
+                  paid off
+    Inputs      : frame - frame number
+    Outputs     : none
+
+***********************************************************************/
+
+void ra_ref( int frame )
+{
+  if ( BITMAP_TEST( sim->ra->ahead, frame )) {
+    BITMAP_CLEAR( sim->ra->ahead, frame );
+    sim->ra_hits++;
+  }
+}
+
+
+/**********************************************************************
+
+    Function    : ra_evicted
+    Description : a frame's page is being evicted: one read ahead and
+                  never referenced was wasted, so its process's window
+                  shrinks
+    Inputs      : frame - frame number
+    Outputs     : none
+
+***********************************************************************/
+
+void ra_evicted( int frame )
+{
+  ra_stream_t *s;
+
+  if ( !BITMAP_TEST( sim->ra->ahead, frame ))
+    return;
+
+  BITMAP_CLEAR( sim->ra->ahead, frame );
+  sim->ra_misses++;
+
+  s = &sim->ra->stream[sim->physical_mem[frame].pid];
+  if ( s->window > 1 )
+    s->window /= 2;
+}
+
+
+/**********************************************************************
+
+    Function    : ra_write
+    Description : Write the readahead activity, and the faults of the
+                  same machine without it if one ran alongside
+    Inputs      : out - file pointer of output file
+    Outputs     : none
+
+***********************************************************************/
+
+void ra_write( FILE *out )
+{
+  uint64_t pending = sim->ra_pages - sim->ra_hits - sim->ra_misses;
+  uint64_t used = sim->ra_hits + sim->ra_misses;
+
+  fprintf( out, "++++++++++++++++++++ Readahead ++++++++++++++++++\n" );
+  fprintf( out, "windows of %d to %d pages; streams detected: %llu; faults reading ahead: %llu\n",
+	   ( RA_MIN < sim->ra->max ) ? RA_MIN : sim->ra->max, sim->ra->max,
+	   (unsigned long long)sim->ra_streams, (unsigned long long)sim->ra_windows );
+  fprintf( out, "pages read ahead: %llu; hits: %llu; misses (evicted unreferenced): %llu; "
+	   "still resident unreferenced: %llu\n", (unsigned long long)sim->ra_pages,
+	   (unsigned long long)sim->ra_hits, (unsigned long long)sim->ra_misses,
+	   (unsigned long long)pending );
+  fprintf( out, "accuracy: %f\n", used ? (float)sim->ra_hits / used : 0.0 );
+  if ( sim->ra_base )
+    fprintf( out, "page faults: %llu, %llu without readahead (%.2f%% fewer)\n",
+	     (unsigned long long)sim->pfs, (unsigned long long)sim->ra_base->pfs,
+	     sim->ra_base->pfs ? 100.0 * ( (double)sim->ra_base->pfs - (double)sim->pfs ) / sim->ra_base->pfs : 0.0 );
+}
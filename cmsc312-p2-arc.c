@@ -0,0 +1,355 @@
+/**********************************************************************
+
+   File          : cmsc312-p2-arc.c
+
+   Description   : This is ARC, adaptive replacement cache (Megiddo and
+                   Modha).  Resident pages seen once since they last came
+                   in are on t1, pages seen again are on t2, and b1 and
+                   b2 remember the pages last evicted from each.  A fault
+                   on a page in b1 means t1 was too small, and one in b2
+                   that t2 was: the target size p of t1 moves toward
+                   whichever list would have kept the page.  A scan only
+                   passes through t1, so it cannot flush t2
+                   (see .h for applications)
+
+***********************************************************************/
+/**********************************************************************
+Copyright (c) 2016 The Pennsylvania State University
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of The Pennsylvania State University nor the names of its contributors may be used to endorse or promote products derived from this softwiare without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* Include Files */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <assert.h>
+
+/* Project Include Files */
+#include "cmsc312-p2.h"
+
+/* Definitions */
+
+typedef struct arc {
+  qlist_t t1;                 /* resident frames, seen once (head most recent) */
+  qlist_t t2;                 /* resident frames, seen again */
+  qlist_t b1;                 /* ghosts of t1 (directory entries) */
+  qlist_t b2;                 /* ghosts of t2 */
+  qdir_t dir;
+  int *pid;                   /* process owning the page in each frame */
+  uint64_t *fresh;            /* frames not referenced since their page came in */
+  int p;                      /* target length of t1 */
+  int shared;                 /* the frame arrays are the machine's first state's */
+  int hit;                    /* ghost list (1 or 2) the faulting page was on ... */
+  int hit_pid;                /* ... if replacement already took it off */
+  vpn_t hit_page;
+} arc_t;
+
+/* each simulated machine keeps its own lists as sim->repl */
+
+
+/**********************************************************************
+
+    Function    : arc_ghost_hit
+    Description : take a faulting page off the ghost lists, adapting the
+                  target length of t1 toward the list it was on
+    Inputs      : a - arc state
+                  pid - process
+                  page - page number
+    Outputs     : 1 if it was on b1, 2 if on b2, 0 if neither
+
+***********************************************************************/
+
+static int arc_ghost_hit( arc_t *a, int pid, vpn_t page )
+{
+  int e = qdir_find( &a->dir, pid, page );
+  int c = local_frames( ), hit;
+
+  if ( e == QLIST_NONE )
+    return 0;
+
+  if ( qlist_on( &a->b1, e )) {
+    a->p += ( a->b2.len > a->b1.len ) ? a->b2.len / a->b1.len : 1;
+    if ( a->p > c )
+      a->p = c;
+    qlist_remove( &a->b1, e );
+    hit = 1;
+  }
+  else {
+    a->p -= ( a->b1.len > a->b2.len ) ? a->b1.len / a->b2.len : 1;
+    if ( a->p < 0 )
+      a->p = 0;
+    qlist_remove( &a->b2, e );
+    hit = 2;
+  }
+
+  qdir_del( &a->dir, e );
+  return hit;
+}
+
+
+/**********************************************************************
+
+    Function    : arc_trim
+    Description : keep the ghosts within bounds before a page that was
+                  on neither ghost list comes in
+    Inputs      : a - arc state
+    Outputs     : none
+
+***********************************************************************/
+
+static void arc_trim( arc_t *a )
+{
+  int c = local_frames( );
+
+  if ( a->t1.len + a->b1.len >= c ) {
+    if ( a->b1.len )
+      qdir_drop( &a->dir, &a->b1 );
+  }
+  else if ( a->t1.len + a->t2.len + a->b1.len + a->b2.len >= 2 * c )
+    qdir_drop( &a->dir, &a->b2 );
+}
+
+
+/**********************************************************************
+
+    Function    : init_arc
+    Description : initialize empty lists, with room for c ghosts (a
+                  process's state under local replacement shares the
+                  frame arrays of the machine's, and its room for ghosts
+                  grows as they come)
+    Inputs      : tr - input trace
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int init_arc( trace_t *tr )
+{
+  arc_t *model = (arc_t *)sim->repl;
+  arc_t *a = (arc_t *)calloc( 1, sizeof(arc_t) );
+  int c = sim->frames, n = c + 1;
+
+  if (( sim->repl = a ) == NULL )
+    return -1;
+
+  if ( model ) {
+    a->shared = 1;
+    a->pid = model->pid;
+    a->fresh = model->fresh;
+    qlist_share( &a->t1, &model->t1 );
+    qlist_share( &a->t2, &model->t2 );
+    n = ( n > QDIR_MIN ) ? QDIR_MIN : n;
+  }
+  else {
+    a->pid = (int *)calloc( c, sizeof(int) );
+    a->fresh = (uint64_t *)calloc( BITMAP_WORDS( c ), sizeof(uint64_t) );
+    if (( a->pid == NULL ) || ( a->fresh == NULL ) || qlist_init( &a->t1, c ) || qlist_init( &a->t2, c ))
+      return -1;
+  }
+
+  if ( qdir_init( &a->dir, n ) || qlist_init( &a->b1, n ) || qlist_init( &a->b2, n ))
+    return -1;
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : exit_arc
+    Description : free the lists
+    Inputs      : none
+    Outputs     : none
+
+***********************************************************************/
+
+void exit_arc( void )
+{
+  arc_t *a = (arc_t *)sim->repl;
+
+  if ( !a->shared ) {
+    qlist_free( &a->t1 );
+    qlist_free( &a->t2 );
+    free( a->fresh );
+    free( a->pid );
+  }
+  qlist_free( &a->b1 );
+  qlist_free( &a->b2 );
+  qdir_free( &a->dir );
+  free( a );
+}
+
+
+/**********************************************************************
+
+    Function    : replace_arc
+    Description : choose a victim from t1 or t2, by the target length
+                  of t1 after adapting it to the faulting page
+    Inputs      : pid - process id of victim frame 
+                  victim - frame assignment 
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int replace_arc( int *pid, frame_t **victim )
+{
+  arc_t *a = (arc_t *)sim->repl;
+  int c = local_frames( );
+  qlist_t *from, *ghost, *lists[2] = { &a->b1, &a->b2 };
+  int frame;
+
+  /* a quota that shrank may leave the target past the frames managed */
+  if ( a->p > c )
+    a->p = c;
+
+  a->hit = arc_ghost_hit( a, sim->fault_pid, sim->fault_page );
+  a->hit_pid = sim->fault_pid;
+  a->hit_page = sim->fault_page;
+
+  if ( a->hit == 0 )
+    arc_trim( a );
+
+  /* t1 and its ghosts fill the cache: t1's oldest page is not remembered */
+  if (( a->hit == 0 ) && ( a->t1.len >= c )) {
+    from = &a->t1;
+    ghost = NULL;
+  }
+  else if ( a->t1.len && (( a->t1.len > a->p ) || (( a->hit == 2 ) && ( a->t1.len == a->p )))) {
+    from = &a->t1;
+    ghost = &a->b1;
+  }
+  else {
+    from = a->t2.len ? &a->t2 : &a->t1;
+    ghost = a->t2.len ? &a->b2 : &a->b1;
+  }
+
+  if (( frame = from->tail ) == QLIST_NONE )
+    return -1;
+  qlist_remove( from, frame );
+
+  // Remember the victim on the ghost list of the list it left
+  if ( ghost ) {
+    while ( a->b1.len + a->b2.len > c )
+      qdir_drop( &a->dir, ( a->b1.len > a->b2.len ) ? &a->b1 : &a->b2 );
+    if ( qdir_room( &a->dir, lists, 2 ))
+      return -1;
+    qdir_ghost( &a->dir, ghost, a->pid[frame], sim->physical_mem[frame].page );
+  }
+
+  *victim = &(sim->physical_mem[frame]);
+  *pid = a->pid[frame];
+
+  EVENT( LOG_FAULTS, EV_VICTIM, *pid, sim->physical_mem[frame].page, frame, 0 );
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : update_arc
+    Description : a page was loaded into a frame: t2 if it was a ghost,
+                  else t1
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int update_arc( int pid, frame_t *f )
+{
+  arc_t *a = (arc_t *)sim->repl;
+  int hit;
+
+  /* replacement already looked this page up, unless a free frame took it */
+  if (( a->hit_pid == pid ) && ( a->hit_page == f->page ) && ( a->hit >= 0 ))
+    hit = a->hit;
+  else if (( hit = arc_ghost_hit( a, pid, f->page )) == 0 )
+    arc_trim( a );
+  a->hit = -1;
+
+  a->pid[f->number] = pid;
+  BITMAP_SET( a->fresh, f->number );
+  qlist_push( hit ? &a->t2 : &a->t1, f->number );
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : ref_arc
+    Description : a resident page was referenced again: to the head
+                  of t2 (the access that faulted it in does not count)
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int ref_arc( int pid, frame_t *f )
+{
+  arc_t *a = (arc_t *)sim->repl;
+
+  if ( BITMAP_TEST( a->fresh, f->number )) {
+    BITMAP_CLEAR( a->fresh, f->number );
+    return 0;
+  }
+
+  if ( qlist_on( &a->t1, f->number ))
+    qlist_remove( &a->t1, f->number );
+  else if ( qlist_on( &a->t2, f->number ))
+    qlist_remove( &a->t2, f->number );
+  else
+    return 0;
+
+  qlist_push( &a->t2, f->number );
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : release_arc
+    Description : the page in frame f was swapped out with its process:
+                  it leaves t1 or t2 without a ghost
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int release_arc( int pid, frame_t *f )
+{
+  arc_t *a = (arc_t *)sim->repl;
+
+  BITMAP_CLEAR( a->fresh, f->number );
+  if ( qlist_on( &a->t1, f->number ))
+    qlist_remove( &a->t1, f->number );
+  else if ( qlist_on( &a->t2, f->number ))
+    qlist_remove( &a->t2, f->number );
+
+  return 0;
+}
@@ -0,0 +1,300 @@
+/**********************************************************************
+
+   File          : cmsc312-p2-car.c
+
+   Description   : This is CAR, clock with adaptive replacement (Bansal
+                   and Modha).  It is ARC with its two LRU lists of
+                   resident pages replaced by clocks, so a hit only sets
+                   a reference bit.  The hand of t1 passes referenced
+                   pages on to t2; ghosts b1 and b2 adapt the target
+                   length p of t1 as in ARC
+                   (see .h for applications)
+
+***********************************************************************/
+/**********************************************************************
+Copyright (c) 2016 The Pennsylvania State University
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of The Pennsylvania State University nor the names of its contributors may be used to endorse or promote products derived from this softwiare without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* Include Files */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <assert.h>
+
+/* Project Include Files */
+#include "cmsc312-p2.h"
+
+/* Definitions */
+
+typedef struct car {
+  qlist_t t1;                 /* clock of frames seen once: tail is the hand */
+  qlist_t t2;                 /* clock of frames seen again */
+  qlist_t b1;                 /* ghosts of t1 (directory entries), head most recent */
+  qlist_t b2;                 /* ghosts of t2 */
+  qdir_t dir;
+  uint64_t *ref;              /* reference bit per frame */
+  uint64_t *fresh;            /* frames not referenced since their page came in */
+  int *pid;                   /* process owning the page in each frame */
+  int p;                      /* target length of t1 */
+  int shared;                 /* the frame arrays are the machine's first state's */
+} car_t;
+
+/* each simulated machine keeps its own clocks as sim->repl */
+
+
+/**********************************************************************
+
+    Function    : init_car
+    Description : initialize empty clocks, with room for the ghosts (a
+                  process's state under local replacement shares the
+                  frame arrays of the machine's, and its room for ghosts
+                  grows as they come)
+    Inputs      : tr - input trace
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int init_car( trace_t *tr )
+{
+  car_t *model = (car_t *)sim->repl;
+  car_t *a = (car_t *)calloc( 1, sizeof(car_t) );
+  int c = sim->frames, n = c + 1;
+
+  if (( sim->repl = a ) == NULL )
+    return -1;
+
+  if ( model ) {
+    a->shared = 1;
+    a->pid = model->pid;
+    a->ref = model->ref;
+    a->fresh = model->fresh;
+    qlist_share( &a->t1, &model->t1 );
+    qlist_share( &a->t2, &model->t2 );
+    n = ( n > QDIR_MIN ) ? QDIR_MIN : n;
+  }
+  else {
+    a->pid = (int *)calloc( c, sizeof(int) );
+    a->ref = (uint64_t *)calloc( BITMAP_WORDS( c ), sizeof(uint64_t) );
+    a->fresh = (uint64_t *)calloc( BITMAP_WORDS( c ), sizeof(uint64_t) );
+    if (( a->pid == NULL ) || ( a->ref == NULL ) || ( a->fresh == NULL ) ||
+	qlist_init( &a->t1, c ) || qlist_init( &a->t2, c ))
+      return -1;
+  }
+
+  /* the victim is remembered before the ghosts are trimmed: c + 1 */
+  if ( qdir_init( &a->dir, n ) || qlist_init( &a->b1, n ) || qlist_init( &a->b2, n ))
+    return -1;
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : exit_car
+    Description : free the clocks
+    Inputs      : none
+    Outputs     : none
+
+***********************************************************************/
+
+void exit_car( void )
+{
+  car_t *a = (car_t *)sim->repl;
+
+  if ( !a->shared ) {
+    qlist_free( &a->t1 );
+    qlist_free( &a->t2 );
+    free( a->ref );
+    free( a->fresh );
+    free( a->pid );
+  }
+  qlist_free( &a->b1 );
+  qlist_free( &a->b2 );
+  qdir_free( &a->dir );
+  free( a );
+}
+
+
+/**********************************************************************
+
+    Function    : replace_car
+    Description : sweep t1 (if longer than its target) or t2 for a page
+                  without its reference bit; referenced pages get a
+                  second chance at the back of t2
+    Inputs      : pid - process id of victim frame 
+                  victim - frame assignment 
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int replace_car( int *pid, frame_t **victim )
+{
+  car_t *a = (car_t *)sim->repl;
+  qlist_t *from, *ghost, *lists[2] = { &a->b1, &a->b2 };
+  int c = local_frames( ), frame;
+
+  /* a quota that shrank may leave the target past the frames managed */
+  if ( a->p > c )
+    a->p = c;
+
+  while ( TRUE ) {
+    if (( a->t1.len >= (( a->p > 1 ) ? a->p : 1 )) || ( a->t2.len == 0 )) {
+      from = &a->t1;
+      ghost = &a->b1;
+    }
+    else {
+      from = &a->t2;
+      ghost = &a->b2;
+    }
+
+    if (( frame = from->tail ) == QLIST_NONE )
+      return -1;
+    qlist_remove( from, frame );
+
+    if ( !BITMAP_TEST( a->ref, frame ))
+      break;
+
+    BITMAP_CLEAR( a->ref, frame );
+    qlist_push( &a->t2, frame );
+  }
+
+  // Remember the victim on the ghost list of the clock it left
+  while ( a->b1.len + a->b2.len > c )
+    qdir_drop( &a->dir, ( a->b1.len > a->b2.len ) ? &a->b1 : &a->b2 );
+  if ( qdir_room( &a->dir, lists, 2 ))
+    return -1;
+  qdir_ghost( &a->dir, ghost, a->pid[frame], sim->physical_mem[frame].page );
+
+  *victim = &(sim->physical_mem[frame]);
+  *pid = a->pid[frame];
+
+  EVENT( LOG_FAULTS, EV_VICTIM, *pid, sim->physical_mem[frame].page, frame, 0 );
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : update_car
+    Description : a page was loaded into a frame: t2 if it was a ghost
+                  (adapting p), else t1
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int update_car( int pid, frame_t *f )
+{
+  car_t *a = (car_t *)sim->repl;
+  int e = qdir_find( &a->dir, pid, f->page );
+  int c = local_frames( );
+
+  a->pid[f->number] = pid;
+  BITMAP_CLEAR( a->ref, f->number );
+  BITMAP_SET( a->fresh, f->number );
+
+  if ( e == QLIST_NONE ) {
+    /* keep the ghosts within bounds */
+    if ( a->t1.len + a->b1.len >= c ) {
+      if ( a->b1.len )
+        qdir_drop( &a->dir, &a->b1 );
+    }
+    else if ( a->t1.len + a->t2.len + a->b1.len + a->b2.len >= 2 * c )
+      qdir_drop( &a->dir, &a->b2 );
+    qlist_push( &a->t1, f->number );
+    return 0;
+  }
+
+  if ( qlist_on( &a->b1, e )) {
+    a->p += ( a->b2.len > a->b1.len ) ? a->b2.len / a->b1.len : 1;
+    if ( a->p > c )
+      a->p = c;
+    qlist_remove( &a->b1, e );
+  }
+  else {
+    a->p -= ( a->b1.len > a->b2.len ) ? a->b1.len / a->b2.len : 1;
+    if ( a->p < 0 )
+      a->p = 0;
+    qlist_remove( &a->b2, e );
+  }
+
+  qdir_del( &a->dir, e );
+  qlist_push( &a->t2, f->number );
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : ref_car
+    Description : a resident page was referenced again: set its
+                  reference bit (the access that faulted it in does not)
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int ref_car( int pid, frame_t *f )
+{
+  car_t *a = (car_t *)sim->repl;
+
+  if ( BITMAP_TEST( a->fresh, f->number ))
+    BITMAP_CLEAR( a->fresh, f->number );
+  else
+    BITMAP_SET( a->ref, f->number );
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : release_car
+    Description : the page in frame f was swapped out with its process:
+                  it leaves its clock without a ghost
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int release_car( int pid, frame_t *f )
+{
+  car_t *a = (car_t *)sim->repl;
+
+  BITMAP_CLEAR( a->ref, f->number );
+  BITMAP_CLEAR( a->fresh, f->number );
+  if ( qlist_on( &a->t1, f->number ))
+    qlist_remove( &a->t1, f->number );
+  else if ( qlist_on( &a->t2, f->number ))
+    qlist_remove( &a->t2, f->number );
+
+  return 0;
+}
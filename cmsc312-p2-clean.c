@@ -0,0 +1,297 @@
+/**********************************************************************
+
+   File          : cmsc312-p2-clean.c
+
+   Description   : The page cleaner: a page-out daemon that writes dirty
+                   pages back before replacement picks them, so that an
+                   eviction rarely waits for a write.  It wakes at a
+                   fault once fewer than clean_low frames are free or
+                   hold clean pages, and sweeps a hand over the frames
+                   like a clock: a page referenced since the hand last
+                   passed is skipped (it is likely written again), and
+                   idle dirty pages are gathered into one write-back of
+                   up to clean_batch pages.  The writes overlap the
+                   faulting processes' work, so only disk time they do
+                   not fit into is charged
+                   (see .h for applications)
+
+***********************************************************************/
+/**********************************************************************
+Copyright (c) 2016 The Pennsylvania State University
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of The Pennsylvania State University nor the names of its contributors may be used to endorse or promote products derived from this softwiare without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* Include Files */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <assert.h>
+
+/* Project Include Files */
+#include "cmsc312-p2.h"
+
+/* Definitions */
+#define CLEAN_SCAN    8             /* frames examined per page a wake may write */
+
+
+/**********************************************************************
+
+    Function    : clean_init
+    Description : start the page cleaner on the current machine
+    Inputs      : none
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int clean_init( void )
+{
+  cleaner_t *c = (cleaner_t *)calloc( 1, sizeof(cleaner_t) );
+
+  if (( sim->clean = c ) == NULL )
+    return -1;
+
+  c->seen = (uint64_t *)calloc( BITMAP_WORDS( sim->frames ), sizeof(uint64_t) );
+  c->cleaned = (uint64_t *)calloc( BITMAP_WORDS( sim->frames ), sizeof(uint64_t) );
+  c->batch = (frame_t **)malloc( sizeof(frame_t *) * clean_batch );
+  c->hand = 0;
+
+  return (( c->seen == NULL ) || ( c->cleaned == NULL ) || ( c->batch == NULL )) ? -1 : 0;
+}
+
+
+/**********************************************************************
+
+    Function    : clean_exit
+    Description : free the page cleaner
+    Inputs      : none
+    Outputs     : none
+
+***********************************************************************/
+
+void clean_exit( void )
+{
+  if ( sim->clean == NULL )
+    return;
+
+  free( sim->clean->seen );
+  free( sim->clean->cleaned );
+  free( sim->clean->batch );
+  free( sim->clean );
+  sim->clean = NULL;
+}
+
+
+/**********************************************************************
+
+    Function    : clean_ref
+    Description : the page in a frame was referenced -- the hand passes
+                  over it next time
+    Inputs      : frame - frame number
+    Outputs     : none
+
+***********************************************************************/
+
+void clean_ref( int frame )
+{
+  BITMAP_SET( sim->clean->seen, frame );
+}
+
+
+/**********************************************************************
+
+    Function    : clean_wake
+    Description : run the cleaner if too few frames can be taken without
+                  a write: gather idle dirty pages under the hand and
+                  write them back together
+    Inputs      : none
+    Outputs     : pages written back, or -1 on a swap file error
+
+***********************************************************************/
+
+int clean_wake( void )
+{
+  cleaner_t *c = sim->clean;
+  ptentry_t *pte;
+  frame_t *f;
+  int scan, n = 0;
+
+  /* free frames and clean pages are both taken without a write */
+  if ( sim->frames - sim->dirty >= clean_low )
+    return 0;
+
+  sim->clean_wakes++;
+
+  scan = ( CLEAN_SCAN * clean_batch < sim->frames ) ? CLEAN_SCAN * clean_batch : sim->frames;
+  while (( scan-- > 0 ) && ( n < clean_batch )) {
+    f = &sim->physical_mem[c->hand];
+    c->hand = ( c->hand + 1 == sim->frames ) ? 0 : c->hand + 1;
+
+    if ( !f->allocated )
+      continue;
+
+    /* referenced since the hand last passed: leave it another lap */
+    if ( BITMAP_TEST( c->seen, f->number )) {
+      BITMAP_CLEAR( c->seen, f->number );
+      continue;
+    }
+
+    pte = pt_lookup( f->pid, f->page, 0, NULL );
+    if ( !( pte->bits & DIRTYBIT ))
+      continue;
+
+    /* the page joins the write-back; its frame is clean once it is out */
+    pte->bits &= ~DIRTYBIT;
+    sim->dirty--;
+    BITMAP_SET( c->cleaned, f->number );
+    c->batch[n++] = f;
+    EVENT( LOG_FAULTS, EV_CLEAN, f->pid, f->page, f->number, n );
+  }
+
+  if ( n ) {
+    sim->clean_batches++;
+    sim->clean_pages += n;
+
+    /* a real swap file takes the batch in one write */
+    if ( sim->swap && swap_clean( c->batch, n ))
+      return -1;
+  }
+
+  return n;
+}
+
+
+/**********************************************************************
+
+    Function    : clean_evicted
+    Description : a frame's page is being evicted: if the cleaner wrote
+                  it back, count whether that saved the eviction a write
+    Inputs      : frame - frame number
+                  dirty - the page is dirty (written since it was cleaned)
+    Outputs     : none
+
+***********************************************************************/
+
+void clean_evicted( int frame, int dirty )
+{
+  cleaner_t *c = sim->clean;
+
+  if ( !BITMAP_TEST( c->cleaned, frame ))
+    return;
+
+  BITMAP_CLEAR( c->cleaned, frame );
+  if ( dirty )
+    sim->clean_redirtied++;
+  else
+    sim->clean_avoided++;
+}
+
+
+/**********************************************************************
+
+    Function    : clean_busy
+    Description : disk time of the cleaner's write-backs: positioning
+                  once per write-back, then a transfer per page
+    Inputs      : none
+    Outputs     : time in ms
+
+***********************************************************************/
+
+static float clean_busy( void )
+{
+  return (float)sim->clean_batches * SWAP_OUT_OVERHEAD +
+    (float)( sim->clean_pages - sim->clean_batches ) * CLEAN_PAGE_OVERHEAD;
+}
+
+
+/**********************************************************************
+
+    Function    : clean_idle
+    Description : time the disk is not needed by faults: their trap and
+                  restart, and the accesses between them
+    Inputs      : none
+    Outputs     : time in ms
+
+***********************************************************************/
+
+static float clean_idle( void )
+{
+  return (float)sim->pfs * ( PF_OVERHEAD + RESTART_OVERHEAD ) +
+    (float)( sim->total_accesses - sim->pfs ) * MEMORY_ACCESS_TIME / 1000000.0;
+}
+
+
+/**********************************************************************
+
+    Function    : clean_stall
+    Description : the cleaner's disk time that does not fit while the
+                  disk is idle -- faults wait behind it
+    Inputs      : none
+    Outputs     : time in ms
+
+***********************************************************************/
+
+float clean_stall( void )
+{
+  float busy, idle;
+
+  if ( sim->clean == NULL )
+    return 0.0;
+
+  busy = clean_busy( );
+  idle = clean_idle( );
+  return ( busy > idle ) ? busy - idle : 0.0;
+}
+
+
+/**********************************************************************
+
+    Function    : clean_write
+    Description : Write the page cleaner's activity
+    Inputs      : out - file pointer of output file
+    Outputs     : none
+
+***********************************************************************/
+
+void clean_write( FILE *out )
+{
+  float busy = clean_busy( ), stall = clean_stall( );
+
+  fprintf( out, "++++++++++++++++++++ Page Cleaner ++++++++++++++++++\n" );
+  fprintf( out, "wakes under %d free or clean frames; write-backs of up to %d pages "
+	   "(%dms, then %dms a page)\n", clean_low, clean_batch, SWAP_OUT_OVERHEAD, CLEAN_PAGE_OVERHEAD );
+  fprintf( out, "wakes: %llu; write-backs: %llu (%llu pages, %.2f per write-back)\n",
+	   (unsigned long long)sim->clean_wakes, (unsigned long long)sim->clean_batches,
+	   (unsigned long long)sim->clean_pages,
+	   sim->clean_batches ? (float)sim->clean_pages / sim->clean_batches : 0.0 );
+  fprintf( out, "cleaned pages evicted: %llu without a write (dirty evictions avoided), "
+	   "%llu dirtied again\n", (unsigned long long)sim->clean_avoided,
+	   (unsigned long long)sim->clean_redirtied );
+  fprintf( out, "dirty evictions still written on the fault path: %llu\n",
+	   (unsigned long long)sim->swaps );
+  fprintf( out, "cleaner disk time: %.0fms; %.0fms overlapped, %.0fms stalling faults\n",
+	   busy, busy - stall, stall );
+}
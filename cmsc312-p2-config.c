@@ -0,0 +1,323 @@
+/**********************************************************************
+
+   File          : cmsc312-p2-config.c
+
+   Description   : This is the runtime configuration of the simulated
+                   machine: memory geometry set from the command line or
+                   a "key = value" config file (see .h for applications)
+
+***********************************************************************/
+/**********************************************************************
+Copyright (c) 2016 The Pennsylvania State University
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of The Pennsylvania State University nor the names of its contributors may be used to endorse or promote products derived from this softwiare without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* Include Files */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <assert.h>
+
+/* Project Include Files */
+#include "cmsc312-p2.h"
+
+/* Definitions */
+#define LINE_MAX_LEN 256
+
+/* memory geometry -- defaults from the .h, overridden at startup */
+int page_size = PAGE_SIZE;
+int page_shift;             /* log2(page_size), set by config_check */
+unsigned int page_mask;     /* page_size - 1 */
+int va_bits = VA_BITS;
+int pt_levels = PT_LEVELS;
+int pt_mode = PT_RADIX;
+int huge_pages = 0;         /* promote dense regions to huge pages */
+int huge_order = HUGE_ORDER;
+int huge_promote = HUGE_PROMOTE;
+int pt_level_bits[PT_MAX_LEVELS];   /* set by config_check */
+int pt_level_shift[PT_MAX_LEVELS];
+int physical_frames = PHYSICAL_FRAMES;
+int max_processes = MAX_PROCESSES;
+int tlb_entries = TLB_ENTRIES;
+int tlb_ways = TLB_WAYS;    /* entries per set; 0 = fully associative */
+int tlb_replacement = TLB_REPL_LRU;
+int tlb_asids = TLB_ASIDS;  /* address-space IDs of a tagged TLB */
+int tlb_tagged = 0;         /* 0 = flush the TLB on context switch */
+int ws_window = 0;          /* working set window; 0 = working sets not tracked */
+int load_control = LOAD_OFF;
+int pff_high = PFF_HIGH;
+int pff_low = PFF_LOW;
+int local_quota = LOCAL_GLOBAL;
+int clean_low = 0;          /* frames kept clean or free; 0 = no page cleaner */
+int clean_batch = CLEAN_BATCH;
+int swap_batch = SWAP_BATCH;
+int swap_direct = 0;        /* 1 = swap file opened O_DIRECT | O_DSYNC */
+char *swap_path = NULL;     /* swap file; NULL = swapping only modeled */
+int readahead_max = 0;      /* largest readahead window; 0 = demand paging only */
+
+/* settable configuration: name in config files, variable, minimum */
+typedef struct config_opt {
+  const char *name;
+  int *var;
+  int min;
+} config_opt_t;
+
+static config_opt_t config_opts[] = {
+  { "page_size",       &page_size,       1 },
+  { "va_bits",         &va_bits,         1 },
+  { "pt_levels",       &pt_levels,       1 },
+  { "pt_mode",         &pt_mode,         0 },  /* 0 = radix, 1 = inverted */
+  { "huge_pages",      &huge_pages,      0 },
+  { "huge_order",      &huge_order,      1 },
+  { "huge_promote",    &huge_promote,    1 },  /* percent resident */
+  { "physical_frames", &physical_frames, 1 },
+  { "max_processes",   &max_processes,   1 },
+  { "tlb_entries",     &tlb_entries,     1 },
+  { "tlb_ways",        &tlb_ways,        0 },
+  { "tlb_replacement", &tlb_replacement, 0 },  /* 0 = LRU, 1 = pseudo-LRU */
+  { "tlb_asids",       &tlb_asids,       1 },
+  { "tlb_tagged",      &tlb_tagged,      0 },  /* 1 = ASID-tagged TLB */
+  { "ws_window",       &ws_window,       0 },  /* references of the process */
+  { "load_control",    &load_control,    0 },  /* 1 = working sets, 2 = PFF */
+  { "pff_high",        &pff_high,        0 },  /* percent of references faulting */
+  { "pff_low",         &pff_low,         0 },
+  { "local_quota",     &local_quota,     0 },  /* 0 = global replacement */
+  { "clean_low",       &clean_low,       0 },  /* frames; 0 = no page cleaner */
+  { "clean_batch",     &clean_batch,     1 },  /* pages per write-back */
+  { "swap_batch",      &swap_batch,      1 },  /* evicted pages per swap file write */
+  { "swap_direct",     &swap_direct,     0 },  /* 1 = bypass the page cache */
+  { "readahead",       &readahead_max,   0 },  /* pages; 0 = demand paging only */
+};
+
+#define NUM_CONFIG_OPTS  (int)( sizeof(config_opts) / sizeof(config_opts[0]) )
+
+
+/**********************************************************************
+
+    Function    : config_set
+    Description : set one configuration value by name
+    Inputs      : name - option name (see config_opts)
+                  value - value as text (decimal, or hex with 0x)
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int config_set( const char *name, const char *value )
+{
+  char *end;
+  long v;
+  int i;
+
+  for ( i = 0; i < NUM_CONFIG_OPTS; i++ ) {
+    if ( strcmp( name, config_opts[i].name ) == 0 )
+      break;
+  }
+
+  if ( i == NUM_CONFIG_OPTS ) {
+    fprintf( stderr, "config: unknown option %s\n", name );
+    return -1;
+  }
+
+  errno = 0;
+  v = strtol( value, &end, 0 );
+  if ( errno || ( end == value ) || *end || ( v < config_opts[i].min ) || ( v > 0x7fffffff )) {
+    fprintf( stderr, "config: bad value %s for %s\n", value, name );
+    return -1;
+  }
+
+  *config_opts[i].var = (int)v;
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : config_load
+    Description : read "key = value" lines ('#' starts a comment)
+    Inputs      : path - config file name
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int config_load( const char *path )
+{
+  FILE *fp;
+  char line[LINE_MAX_LEN];
+  char *key, *value, *p;
+  int err = 0;
+
+  if (( fp = fopen( path, "r" )) == NULL ) {
+    fprintf( stderr, "config: cannot open %s\n", path );
+    return -1;
+  }
+
+  while ( !err && fgets( line, LINE_MAX_LEN, fp )) {
+    if (( p = strchr( line, '#' )) != NULL )
+      *p = 0;
+
+    /* trim and split at '=' */
+    for ( key = line; isspace( (unsigned char)*key ); key++ );
+    if ( *key == 0 )
+      continue;
+
+    if (( value = strchr( key, '=' )) == NULL ) {
+      fprintf( stderr, "config: expected key = value: %s\n", key );
+      err = -1;
+      break;
+    }
+
+    for ( p = value; p > key && isspace( (unsigned char)p[-1] ); p-- );
+    *p = 0;
+    for ( value++; isspace( (unsigned char)*value ); value++ );
+    for ( p = value + strlen( value ); p > value && isspace( (unsigned char)p[-1] ); p-- );
+    *p = 0;
+
+    err = config_set( key, value );
+  }
+
+  fclose( fp );
+  return err;
+}
+
+
+/**********************************************************************
+
+    Function    : config_check
+    Description : validate the configuration and derive page shift/mask
+    Inputs      : none
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int config_check( void )
+{
+  int i, shift, ways;
+  unsigned int set_mask;
+
+  if ( page_size & ( page_size - 1 )) {
+    fprintf( stderr, "config: page_size must be a power of two\n" );
+    return -1;
+  }
+
+  for ( page_shift = 0; ( 1 << page_shift ) < page_size; page_shift++ );
+  page_mask = page_size - 1;
+
+  /* radix page table: split the page number bits over the levels,
+     giving any extra bits to the levels nearest the root */
+  if (( va_bits > 64 ) || ( pt_levels > PT_MAX_LEVELS ) ||
+      ( va_bits - page_shift < pt_levels )) {
+    fprintf( stderr, "config: need va_bits <= 64, pt_levels <= %d, and a page number bit per level\n",
+	     PT_MAX_LEVELS );
+    return -1;
+  }
+
+  if (( pt_mode != PT_RADIX ) && ( pt_mode != PT_INVERTED )) {
+    fprintf( stderr, "config: pt_mode must be 0 (radix) or 1 (inverted)\n" );
+    return -1;
+  }
+
+  for ( i = pt_levels - 1, shift = 0; i >= 0; i-- ) {
+    pt_level_bits[i] = ( va_bits - page_shift ) / pt_levels +
+      ( i < ( va_bits - page_shift ) % pt_levels );
+    pt_level_shift[i] = shift;
+    shift += pt_level_bits[i];
+  }
+
+  /* huge pages are regions of a radix leaf, made of whole frame blocks */
+  if ( huge_pages && (( pt_mode != PT_RADIX ) || ( huge_order > pt_level_bits[pt_levels-1] ) ||
+		      ( huge_order > 30 ) || (( 1 << huge_order ) > physical_frames ) ||
+		      ( huge_promote > 100 ))) {
+    fprintf( stderr, "config: huge pages need radix page tables with huge_order <= %d leaf bits,\n"
+	     "        at least 2^huge_order frames, and huge_promote <= 100\n",
+	     pt_level_bits[pt_levels-1] );
+    return -1;
+  }
+
+  if ( config_tlb( tlb_entries, &ways, &set_mask ))
+    return -1;
+
+  if (( tlb_replacement != TLB_REPL_LRU ) && ( tlb_replacement != TLB_REPL_PLRU )) {
+    fprintf( stderr, "config: tlb_replacement must be 0 (LRU) or 1 (pseudo-LRU)\n" );
+    return -1;
+  }
+
+  if (( load_control > LOAD_PFF ) || ( pff_low > pff_high )) {
+    fprintf( stderr, "config: load_control must be 0 (off), 1 (working sets) or 2 (page-fault\n"
+	     "        frequency), and pff_low <= pff_high\n" );
+    return -1;
+  }
+
+  if ( local_quota > LOCAL_PFF ) {
+    fprintf( stderr, "config: local_quota must be 0 (global replacement), 1 (equal), 2 (proportional\n"
+	     "        to working sets) or 3 (page-fault frequency)\n" );
+    return -1;
+  }
+
+  /* a page of the swap file starts with a tag naming it */
+  if ( swap_path && (( page_size < SWAP_TAG_BYTES ) || ( swap_direct && ( page_size < 512 )))) {
+    fprintf( stderr, "config: a swap file needs pages of at least %d bytes (512 with swap_direct)\n",
+	     SWAP_TAG_BYTES );
+    return -1;
+  }
+
+  /* load control and changing quotas measure working sets, and look
+     once a window */
+  if (( load_control || ( local_quota >= LOCAL_PROP )) && ( ws_window == 0 ))
+    ws_window = WS_WINDOW;
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : config_tlb
+    Description : organize a TLB of the given size into sets of tlb_ways
+                  entries (each machine of a sweep has its own size)
+    Inputs      : entries - TLB entries
+                  ways - entries per set (out)
+                  set_mask - number of sets - 1 (out)
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int config_tlb( int entries, int *ways, unsigned int *set_mask )
+{
+  int sets;
+
+  *ways = (( tlb_ways == 0 ) || ( tlb_ways > entries )) ? entries : tlb_ways;
+  sets = entries / *ways;
+
+  if (( sets * *ways != entries ) || ( sets & ( sets - 1 ))) {
+    fprintf( stderr, "config: tlb_entries / tlb_ways must be a power of two\n" );
+    return -1;
+  }
+  *set_mask = sets - 1;
+
+  return 0;
+}
@@ -0,0 +1,199 @@
+/**********************************************************************
+
+   File          : cmsc312-p2-conv.c
+
+   Description   : This converts text memory traces ("pid vaddr" per
+                   line, with an optional timestamp column) into the
+                   binary trace format read by cmsc312-p2, and prints
+                   binary event logs written by cmsc312-p2 -v as text
+                   (see .h for applications)
+
+***********************************************************************/
+/**********************************************************************
+Copyright (c) 2016 The Pennsylvania State University
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of The Pennsylvania State University nor the names of its contributors may be used to endorse or promote products derived from this softwiare without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* Include Files */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <assert.h>
+
+/* Project Include Files */
+#include "cmsc312-p2.h"
+
+/* Definitions */
+#define USAGE "cmsc312-p2-conv [-s bytes] <input.txt> <output.bin> [-t]\n" \
+              "  -s bytes  page size the simulator will run at (writes are\n" \
+              "            derived from the address within the page)\n" \
+              "  -t        keep a timestamp per record\n" \
+              "cmsc312-p2-conv -d <event.log>\n"
+#define LINE_MAX_LEN 256
+
+static const char *event_names[] = {
+  [EV_ACCESS]     = "access",
+  [EV_TLB_HIT]    = "tlb-hit",
+  [EV_TLB_MISS]   = "tlb-miss",
+  [EV_PT_HIT]     = "pt-hit",
+  [EV_PAGE_FAULT] = "page-fault",
+  [EV_FREE_FRAME] = "free-frame",
+  [EV_REPLACE]    = "replace",
+  [EV_MAP]        = "map",
+  [EV_INVALIDATE] = "invalidate",
+  [EV_ALLOC]      = "alloc",
+  [EV_VICTIM]     = "victim",
+  [EV_PROMOTE]    = "promote",
+  [EV_DEMOTE]     = "demote",
+  [EV_SUSPEND]    = "suspend",
+  [EV_RESUME]     = "resume",
+  [EV_CLEAN]      = "clean",
+  [EV_PREFETCH]   = "prefetch",
+};
+
+#define NUM_EVENT_NAMES  (int)( sizeof(event_names) / sizeof(event_names[0]) )
+
+
+/**********************************************************************
+
+    Function    : dump_events
+    Description : print a binary event log as text
+    Inputs      : path - event log file name
+    Outputs     : 0 if successful, -1 if failure
+
+***********************************************************************/
+
+static int dump_events( char *path )
+{
+  FILE *in;
+  event_header_t hdr;
+  event_t ev;
+  const char *name;
+
+  if (( in = fopen( path, "r" )) == NULL ) {
+    fprintf( stderr, "event log open failure\n" );
+    return -1;
+  }
+
+  if (( fread( &hdr, sizeof(hdr), 1, in ) != 1 ) || ( hdr.magic != EVENT_MAGIC ) ||
+      ( hdr.version != EVENT_VERSION ) || ( hdr.recsize != sizeof(event_t) )) {
+    fprintf( stderr, "not an event log\n" );
+    fclose( in );
+    return -1;
+  }
+
+  while ( fread( &ev, sizeof(ev), 1, in ) == 1 ) {
+    name = (( ev.type < NUM_EVENT_NAMES ) && event_names[ev.type] ) ? event_names[ev.type] : "?";
+    printf( "mech %d %llu %s pid %d 0x%llx frame %d arg %d\n", ev.mech,
+	    (unsigned long long)ev.seq, name, ev.pid, (unsigned long long)ev.vaddr,
+	    ev.frame, ev.arg );
+  }
+
+  fclose( in );
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : main
+    Description : convert a text trace into a binary trace, its ops
+                  derived at the page size given (default PAGE_SIZE)
+    Inputs      : argc - number of command line parameters
+                  argv - the text of the arguments
+    Outputs     : 0 if successful, -1 if failure
+
+***********************************************************************/
+
+int main( int argc, char **argv )
+{
+  FILE *in, *out;
+  char line[LINE_MAX_LEN];
+  unsigned int flags = 0;
+  uint64_t count = 0, time;
+  unsigned long long stamp, vaddr;
+  int pid, n, c;
+
+  while (( c = getopt( argc, argv, "d:s:t" )) != -1 ) {
+    switch ( c ) {
+      case 'd':
+	return dump_events( optarg );
+      case 's':
+	/* ops are baked in at this page size, as trace_text_op derives them */
+	if ( config_set( "page_size", optarg ) || config_check( ))
+	  exit( -1 );
+	break;
+      case 't':
+	/* keep a timestamp per record (third column, else the line index) */
+	flags |= TRACE_HAS_TIME;
+	break;
+      default:
+	fprintf( stderr, USAGE );
+	exit( -1 );
+    }
+  }
+
+  /* Check for arguments */
+  if ( argc - optind != 2 ) {
+    fprintf( stderr, "missing or bad command line arguments\n" );
+    fprintf( stderr, USAGE );
+    exit( -1 );
+  }
+
+  if (( in = fopen( argv[optind], "r" )) == NULL ) {
+    fprintf( stderr, "input file open failure\n" );
+    return -1;
+  }
+
+  if (( out = trace_create( argv[optind+1], flags )) == NULL ) {
+    fprintf( stderr, "output file open failure\n" );
+    return -1;
+  }
+
+  while ( fgets( line, LINE_MAX_LEN, in )) {
+    n = sscanf( line, "%d %llx %llu", &pid, &vaddr, &stamp );
+    if ( n < 2 )
+      continue;
+
+    time = ( n == 3 ) ? stamp : count;
+    if ( trace_append( out, flags, pid, vaddr, trace_text_op( vaddr ), time )) {
+      fprintf( stderr, "trace write failure\n" );
+      return -1;
+    }
+    count++;
+  }
+
+  fclose( in );
+
+  if ( trace_finish( out, count )) {
+    fprintf( stderr, "trace write failure\n" );
+    return -1;
+  }
+
+  printf( "converted %llu references\n", (unsigned long long)count );
+  return 0;
+}
@@ -0,0 +1,176 @@
+/**********************************************************************
+
+   File          : cmsc312-p2-event.c
+
+   Description   : This is the simulator event log.  Events are appended
+                   to an in-memory ring as fixed-width binary records and
+                   written out a batch at a time (see .h for applications;
+                   cmsc312-p2-conv -d prints a log as text)
+
+***********************************************************************/
+/**********************************************************************
+Copyright (c) 2016 The Pennsylvania State University
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of The Pennsylvania State University nor the names of its contributors may be used to endorse or promote products derived from this softwiare without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* Include Files */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <assert.h>
+
+/* Project Include Files */
+#include "cmsc312-p2.h"
+
+/* Definitions */
+
+/* current level: events above it are dropped at runtime */
+int log_level = LOG_OFF;
+
+/* ring of pending events, flushed to the log file when full */
+static event_t event_ring[EVENT_RING];
+static int event_ct = 0;
+static FILE *event_fp = NULL;
+
+
+/**********************************************************************
+
+    Function    : event_open
+    Description : start logging events at the given level
+    Inputs      : path - event log file name
+                  level - LOG_FAULTS or LOG_FULL
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int event_open( char *path, int level )
+{
+  event_header_t hdr;
+
+  if ( level <= LOG_OFF )
+    return 0;
+
+  if (( event_fp = fopen( path, "w" )) == NULL )
+    return -1;
+
+  memset( &hdr, 0, sizeof(hdr) );
+  hdr.magic = EVENT_MAGIC;
+  hdr.version = EVENT_VERSION;
+  hdr.recsize = sizeof(event_t);
+  if ( fwrite( &hdr, sizeof(hdr), 1, event_fp ) != 1 ) {
+    fclose( event_fp );
+    event_fp = NULL;
+    return -1;
+  }
+
+  event_ct = 0;
+  log_level = level;
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : event_flush
+    Description : write the pending batch of events to the log
+    Inputs      : none
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int event_flush( void )
+{
+  int err = 0;
+
+  if ( event_fp && event_ct &&
+       ( fwrite( event_ring, sizeof(event_t), event_ct, event_fp ) != (size_t)event_ct ))
+    err = -1;
+
+  event_ct = 0;
+  return err;
+}
+
+
+/**********************************************************************
+
+    Function    : event_log
+    Description : record one event of the current machine (callers go
+                  through the EVENT macro), stamped with the machine's
+                  reference count and mechanism
+    Inputs      : type - EV_* event type
+                  pid - process id
+                  vaddr - virtual address or page number (see EV_*)
+                  frame - frame number (or -1)
+                  arg - event specific value
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int event_log( int type, int pid, uint64_t vaddr, int frame, int arg )
+{
+  event_t *ev = &event_ring[event_ct];
+
+  ev->seq = sim->total_accesses;
+  ev->vaddr = vaddr;
+  ev->pid = pid;
+  ev->frame = frame;
+  ev->type = type;
+  ev->arg = arg;
+  ev->mech = sim->mech;
+  ev->reserved = 0;
+
+  if ( ++event_ct == EVENT_RING )
+    return event_flush( );
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : event_close
+    Description : flush the remaining events and close the log
+    Inputs      : none
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int event_close( void )
+{
+  int err;
+
+  if ( event_fp == NULL )
+    return 0;
+
+  err = event_flush( );
+  if ( fclose( event_fp ) != 0 )
+    err = -1;
+
+  event_fp = NULL;
+  log_level = LOG_OFF;
+  return err;
+}
@@ -0,0 +1,357 @@
+/**********************************************************************
+
+   File          : cmsc312-p2-freq.c
+
+   Description   : This is the frequency bucket engine behind the
+                   count-based replacement algorithms.  Resident pages
+                   sit in doubly linked buckets, one bucket per distinct
+                   access count, and the buckets are kept in count order,
+                   so finding the least (or most) counted page, bumping
+                   a count, and adding or removing a page are all O(1).
+                   Nodes and buckets come from fixed pools sized by the
+                   frame count
+                   (see .h for applications)
+
+***********************************************************************/
+/**********************************************************************
+Copyright (c) 2016 The Pennsylvania State University
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of The Pennsylvania State University nor the names of its contributors may be used to endorse or promote products derived from this softwiare without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* Include Files */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <assert.h>
+
+/* Project Include Files */
+#include "cmsc312-p2.h"
+
+/* Definitions */
+
+
+/**********************************************************************
+
+    Function    : freq_create
+    Description : create an empty set of frequency buckets
+    Inputs      : frames - number of frames that may be tracked
+    Outputs     : bucket set if successful, NULL otherwise
+
+***********************************************************************/
+
+freq_t *freq_create( int frames )
+{
+  freq_t *fq = (freq_t *)malloc( sizeof(freq_t) );
+
+  if ( fq == NULL )
+    return NULL;
+
+  fq->lowest = fq->highest = NULL;
+  fq->shared = 0;
+  fq->frames = (freq_node_t **)calloc( frames, sizeof(freq_node_t *) );
+  fq->nodes = pool_create( sizeof(freq_node_t), frames );
+  fq->buckets = pool_create( sizeof(freq_bucket_t), frames + 1 );
+
+  if (( fq->frames == NULL ) || ( fq->nodes == NULL ) || ( fq->buckets == NULL )) {
+    free( fq->frames );
+    pool_destroy( fq->nodes );
+    pool_destroy( fq->buckets );
+    free( fq );
+    return NULL;
+  }
+
+  return fq;
+}
+
+
+/**********************************************************************
+
+    Function    : freq_share
+    Description : create an empty set of buckets over another set's
+                  frame map and pools, for frames tracked by one of the
+                  sets at most (each process's set under local
+                  replacement: together they hold no more nodes, or
+                  buckets, than one set for every frame)
+    Inputs      : from - bucket set to share with
+    Outputs     : bucket set if successful, NULL otherwise
+
+***********************************************************************/
+
+freq_t *freq_share( freq_t *from )
+{
+  freq_t *fq = (freq_t *)malloc( sizeof(freq_t) );
+
+  if ( fq == NULL )
+    return NULL;
+
+  fq->lowest = fq->highest = NULL;
+  fq->frames = from->frames;
+  fq->nodes = from->nodes;
+  fq->buckets = from->buckets;
+  fq->shared = 1;
+
+  return fq;
+}
+
+
+/**********************************************************************
+
+    Function    : freq_destroy
+    Description : release a set of frequency buckets
+    Inputs      : fq - bucket set
+    Outputs     : none
+
+***********************************************************************/
+
+void freq_destroy( freq_t *fq )
+{
+  if ( !fq->shared ) {
+    free( fq->frames );
+    pool_destroy( fq->nodes );
+    pool_destroy( fq->buckets );
+  }
+  free( fq );
+}
+
+
+/**********************************************************************
+
+    Function    : freq_bucket_after
+    Description : link a new, empty bucket into the count order
+    Inputs      : fq - bucket set
+                  prev - bucket to follow (NULL for the lowest position)
+                  count - count of the new bucket
+    Outputs     : new bucket, NULL on allocation failure
+
+***********************************************************************/
+
+static freq_bucket_t *freq_bucket_after( freq_t *fq, freq_bucket_t *prev, int count )
+{
+  freq_bucket_t *b = (freq_bucket_t *)pool_alloc( fq->buckets );
+
+  if ( b == NULL )
+    return NULL;
+
+  b->count = count;
+  b->first = b->last = NULL;
+  b->prev = prev;
+  b->next = prev ? prev->next : fq->lowest;
+
+  if ( b->next )
+    b->next->prev = b;
+  else
+    fq->highest = b;
+
+  if ( prev )
+    prev->next = b;
+  else
+    fq->lowest = b;
+
+  return b;
+}
+
+
+/**********************************************************************
+
+    Function    : freq_unlink
+    Description : take a node out of its bucket, dropping the bucket
+                  if it is left empty
+    Inputs      : fq - bucket set
+                  node - node to unlink
+    Outputs     : none
+
+***********************************************************************/
+
+static void freq_unlink( freq_t *fq, freq_node_t *node )
+{
+  freq_bucket_t *b = node->bucket;
+
+  if ( node->prev ) node->prev->next = node->next;
+  else b->first = node->next;
+  if ( node->next ) node->next->prev = node->prev;
+  else b->last = node->prev;
+
+  node->prev = node->next = NULL;
+  node->bucket = NULL;
+
+  if ( b->first == NULL ) {
+    if ( b->prev ) b->prev->next = b->next;
+    else fq->lowest = b->next;
+    if ( b->next ) b->next->prev = b->prev;
+    else fq->highest = b->prev;
+    pool_free( fq->buckets, b );
+  }
+}
+
+
+/**********************************************************************
+
+    Function    : freq_append
+    Description : add a node as the newest entry of a bucket
+    Inputs      : b - bucket
+                  node - node to add
+    Outputs     : none
+
+***********************************************************************/
+
+static void freq_append( freq_bucket_t *b, freq_node_t *node )
+{
+  node->bucket = b;
+  node->next = NULL;
+  node->prev = b->last;
+
+  if ( b->last ) b->last->next = node;
+  else b->first = node;
+  b->last = node;
+}
+
+
+/**********************************************************************
+
+    Function    : freq_insert
+    Description : start tracking a newly allocated frame at count 0
+    Inputs      : fq - bucket set
+                  pid - process id owning the page
+                  ptentry - page table entry of the page
+                  frame - frame number
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int freq_insert( freq_t *fq, int pid, ptentry_t *ptentry, int frame )
+{
+  freq_bucket_t *b = fq->lowest;
+  freq_node_t *node = (freq_node_t *)pool_alloc( fq->nodes );
+
+  if ( node == NULL )
+    return -1;
+
+  if (( b == NULL ) || ( b->count != 0 )) {
+    if (( b = freq_bucket_after( fq, NULL, 0 )) == NULL ) {
+      pool_free( fq->nodes, node );
+      return -1;
+    }
+  }
+
+  node->pid = pid;
+  node->ptentry = ptentry;
+  freq_append( b, node );
+  fq->frames[frame] = node;
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : freq_touch
+    Description : bump the count of a tracked frame by one
+    Inputs      : fq - bucket set
+                  frame - frame number
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int freq_touch( freq_t *fq, int frame )
+{
+  freq_node_t *node = fq->frames[frame];
+  freq_bucket_t *b, *next;
+
+  if ( node == NULL )
+    return -1;
+
+  b = node->bucket;
+  next = b->next;
+
+  /* the next bucket up may not exist yet */
+  if (( next == NULL ) || ( next->count != b->count + 1 )) {
+    if (( next = freq_bucket_after( fq, b, b->count + 1 )) == NULL )
+      return -1;
+  }
+
+  freq_unlink( fq, node );
+  freq_append( next, node );
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : freq_remove
+    Description : stop tracking a frame
+    Inputs      : fq - bucket set
+                  frame - frame number
+    Outputs     : 0 if successful, -1 if the frame is not tracked
+
+***********************************************************************/
+
+int freq_remove( freq_t *fq, int frame )
+{
+  freq_node_t *node = fq->frames[frame];
+
+  if ( node == NULL )
+    return -1;
+
+  freq_unlink( fq, node );
+  fq->frames[frame] = NULL;
+  pool_free( fq->nodes, node );
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : freq_min
+    Description : least counted page; ties go to the page that reached
+                  that count first
+    Inputs      : fq - bucket set
+    Outputs     : node, or NULL if nothing is tracked
+
+***********************************************************************/
+
+freq_node_t *freq_min( freq_t *fq )
+{
+  return fq->lowest ? fq->lowest->first : NULL;
+}
+
+
+/**********************************************************************
+
+    Function    : freq_max
+    Description : most counted page; ties go to the page that reached
+                  that count first
+    Inputs      : fq - bucket set
+    Outputs     : node, or NULL if nothing is tracked
+
+***********************************************************************/
+
+freq_node_t *freq_max( freq_t *fq )
+{
+  return fq->highest ? fq->highest->first : NULL;
+}
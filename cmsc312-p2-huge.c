@@ -0,0 +1,335 @@
+/**********************************************************************
+
+   File          : cmsc312-p2-huge.c
+
+   Description   : This is huge page support for the radix page tables.
+                   The first fault in an aligned region of 2^huge_order
+                   pages reserves an aligned block of free frames, and
+                   the region's pages fault into the block at their
+                   offsets.  Once huge_promote percent of the region is
+                   resident, the rest is read in and the region is mapped
+                   as one huge page, covered by a single TLB entry.
+                   Evicting any page of it demotes it again.  When free
+                   frames run out, the oldest unpromoted reservation
+                   gives its unused frames back before any page is
+                   replaced
+                   (see .h for applications)
+
+***********************************************************************/
+/**********************************************************************
+Copyright (c) 2016 The Pennsylvania State University
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of The Pennsylvania State University nor the names of its contributors may be used to endorse or promote products derived from this softwiare without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* Include Files */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <assert.h>
+
+/* Project Include Files */
+#include "cmsc312-p2.h"
+
+/* Definitions */
+
+
+/**********************************************************************
+
+    Function    : huge_leaf_extra
+    Description : bytes of region records kept after a leaf's entries
+    Inputs      : entries - page table entries in the leaf
+    Outputs     : size in bytes
+
+***********************************************************************/
+
+size_t huge_leaf_extra( int entries )
+{
+  return (size_t)( entries >> huge_order ) * sizeof(huge_region_t);
+}
+
+
+/**********************************************************************
+
+    Function    : huge_leaf_init
+    Description : set up the region records of a new (zeroed) leaf
+    Inputs      : leaf - the leaf's entries
+                  entries - number of entries
+    Outputs     : none
+
+***********************************************************************/
+
+void huge_leaf_init( ptentry_t *leaf, int entries )
+{
+  huge_region_t *r = (huge_region_t *)( leaf + entries );
+  int i;
+
+  for ( i = 0; i < ( entries >> huge_order ); i++ ) {
+    r[i].first = leaf + ( i << huge_order );
+    r[i].block = -1;
+  }
+}
+
+
+/**********************************************************************
+
+    Function    : huge_region
+    Description : find the region of a page from its entry
+    Inputs      : ptentry - page table entry (in a radix leaf)
+    Outputs     : region record
+
+***********************************************************************/
+
+huge_region_t *huge_region( ptentry_t *ptentry )
+{
+  vpn_t mask = ( (vpn_t)1 << pt_level_bits[pt_levels-1] ) - 1;
+  ptentry_t *leaf = ptentry - ( ptentry->number & mask );
+
+  return (huge_region_t *)( leaf + mask + 1 ) + (( ptentry->number & mask ) >> huge_order );
+}
+
+
+/**********************************************************************
+
+    Function    : huge_block_free
+    Description : are all frames of an aligned block free?
+    Inputs      : f - first frame
+                  n - frames in the block (a power of two)
+    Outputs     : 1 if free, 0 otherwise
+
+***********************************************************************/
+
+static int huge_block_free( int f, int n )
+{
+  uint64_t mask;
+  int w;
+
+  if ( n >= 64 ) {
+    for ( w = f >> 6; w < ( f + n ) >> 6; w++ ) {
+      if ( sim->free_frames[w] != ~0ULL )
+	return 0;
+    }
+    return 1;
+  }
+
+  mask = (( 1ULL << n ) - 1 ) << ( f & 63 );
+  return ( sim->free_frames[f >> 6] & mask ) == mask;
+}
+
+
+/**********************************************************************
+
+    Function    : huge_unlink
+    Description : take a region off the reservation list
+    Inputs      : r - region
+    Outputs     : none
+
+***********************************************************************/
+
+static void huge_unlink( huge_region_t *r )
+{
+  if ( r->prev ) r->prev->next = r->next;
+  else sim->resv_head = r->next;
+  if ( r->next ) r->next->prev = r->prev;
+  else sim->resv_tail = r->prev;
+  r->next = r->prev = NULL;
+}
+
+
+/**********************************************************************
+
+    Function    : huge_frame
+    Description : frame for a faulting page if its region has (or can
+                  now get) a reserved block.  A region only reserves on
+                  its first fault, and takes the lowest aligned block
+                  whose frames are all free
+    Inputs      : pid - process id
+                  ptentry - page table entry of the faulting page
+    Outputs     : frame number, or -1 to allocate the usual way
+
+***********************************************************************/
+
+int huge_frame( int pid, ptentry_t *ptentry )
+{
+  huge_region_t *r = huge_region( ptentry );
+  int n = 1 << huge_order;
+  int f, i;
+
+  if (( r->block < 0 ) && ( r->resident == 0 )) {
+    /* words below free_hint are full, so no free block starts lower */
+    for ( f = ( sim->free_hint << 6 ) & ~( n - 1 ); f + n <= sim->frames; f += n ) {
+      if ( huge_block_free( f, n ))
+	break;
+    }
+    if ( f + n > sim->frames )
+      return -1;
+
+    for ( i = 0; i < n; i++ )
+      BITMAP_CLEAR( sim->free_frames, f + i );
+
+    r->block = f;
+    r->pid = pid;
+    r->prev = sim->resv_tail;
+    r->next = NULL;
+    if ( sim->resv_tail ) sim->resv_tail->next = r;
+    else sim->resv_head = r;
+    sim->resv_tail = r;
+  }
+
+  if (( r->block < 0 ) || r->huge )
+    return -1;
+
+  f = r->block + ( ptentry->number & ( n - 1 ));
+  assert( !sim->physical_mem[f].allocated );
+  return f;
+}
+
+
+/**********************************************************************
+
+    Function    : huge_break
+    Description : give up a region's reservation, freeing its unused
+                  frames
+    Inputs      : r - region
+    Outputs     : none
+
+***********************************************************************/
+
+static void huge_break( huge_region_t *r )
+{
+  int i;
+
+  for ( i = 0; i < ( 1 << huge_order ); i++ ) {
+    if ( !sim->physical_mem[r->block + i].allocated )
+      pt_free_frame( &sim->physical_mem[r->block + i] );
+  }
+
+  huge_unlink( r );
+  r->block = -1;
+  sim->huge_breaks++;
+}
+
+
+/**********************************************************************
+
+    Function    : huge_break_oldest
+    Description : free the unused frames of the oldest reservation
+    Inputs      : none
+    Outputs     : 0 if successful, -1 if there are no reservations
+
+***********************************************************************/
+
+int huge_break_oldest( void )
+{
+  if ( sim->resv_head == NULL )
+    return -1;
+
+  huge_break( sim->resv_head );
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : huge_mapped
+    Description : a page was given a frame
+    Inputs      : ptentry - page table entry of the page
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int huge_mapped( ptentry_t *ptentry )
+{
+  huge_region( ptentry )->resident++;
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : huge_unmapped
+    Description : a page lost its frame: demote its region if it was a
+                  huge page, or give up the region's reservation, as its
+                  pages no longer all fit the block
+    Inputs      : ptentry - page table entry of the page
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int huge_unmapped( ptentry_t *ptentry )
+{
+  huge_region_t *r = huge_region( ptentry );
+
+  r->resident--;
+
+  if ( r->huge ) {
+    EVENT( LOG_FAULTS, EV_DEMOTE, r->pid, r->first->number, r->block, 0 );
+    tlb_invalidate_huge( r->pid, r->first->number );
+    r->huge = 0;
+    r->block = -1;
+    sim->huge_demotions++;
+  }
+  else if ( r->block >= 0 )
+    huge_break( r );
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : huge_check_promote
+    Description : promote a page's region to a huge page once enough of
+                  it is resident, reading in the rest of its pages
+    Inputs      : ptentry - page table entry of a page just mapped
+                  mech - replacement mechanism
+    Outputs     : 1 if promoted, 0 otherwise
+
+***********************************************************************/
+
+int huge_check_promote( ptentry_t *ptentry, int mech )
+{
+  huge_region_t *r = huge_region( ptentry );
+  int n = 1 << huge_order;
+  int i;
+
+  if (( r->block < 0 ) || r->huge || ( r->resident * 100 < huge_promote * n ))
+    return 0;
+
+  for ( i = 0; i < n; i++ ) {
+    if ( !( r->first[i].bits & VALIDBIT )) {
+      pt_alloc_frame( r->pid, &sim->physical_mem[r->block + i], &r->first[i], 0, mech );
+      sim->huge_prefilled++;
+    }
+  }
+
+  huge_unlink( r );
+  r->huge = 1;
+  sim->huge_promotions++;
+  EVENT( LOG_FAULTS, EV_PROMOTE, r->pid, r->first->number, r->block, 0 );
+
+  return 1;
+}
@@ -0,0 +1,220 @@
+/**********************************************************************
+
+   File          : cmsc312-p2-ipt.c
+
+   Description   : This is the inverted page table: one entry per
+                   physical frame, shared by every process and found by
+                   hashing (pid, page) into chains threaded through the
+                   entries.  Its size depends only on the frame count,
+                   not on the address spaces or number of processes
+                   (see .h for applications)
+
+***********************************************************************/
+/**********************************************************************
+Copyright (c) 2016 The Pennsylvania State University
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of The Pennsylvania State University nor the names of its contributors may be used to endorse or promote products derived from this softwiare without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* Include Files */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <assert.h>
+
+/* Project Include Files */
+#include "cmsc312-p2.h"
+
+/* Definitions */
+
+
+/**********************************************************************
+
+    Function    : ipt_init
+    Description : allocate an empty inverted page table with a power of
+                  two of hash anchors, at least one per frame
+    Inputs      : none
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int ipt_init( void )
+{
+  unsigned int n;
+  int i;
+
+  for ( n = 1; n < (unsigned int)sim->frames; n <<= 1 );
+  sim->ipt_mask = n - 1;
+
+  sim->ipt = (ipt_entry_t *)calloc( sim->frames, sizeof(ipt_entry_t) );
+  sim->ipt_anchor = (int *)malloc( sizeof(int) * n );
+
+  if (( sim->ipt == NULL ) || ( sim->ipt_anchor == NULL ))
+    return -1;
+
+  for ( i = 0; i < (int)n; i++ )
+    sim->ipt_anchor[i] = -1;
+  for ( i = 0; i < sim->frames; i++ )
+    sim->ipt[i].pid = -1;
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : ipt_exit
+    Description : free the inverted page table
+    Inputs      : none
+    Outputs     : none
+
+***********************************************************************/
+
+void ipt_exit( void )
+{
+  free( sim->ipt );
+  free( sim->ipt_anchor );
+}
+
+
+/**********************************************************************
+
+    Function    : ipt_bytes
+    Description : memory used by the inverted page table
+    Inputs      : none
+    Outputs     : size in bytes
+
+***********************************************************************/
+
+uint64_t ipt_bytes( void )
+{
+  return (uint64_t)sim->frames * sizeof(ipt_entry_t) +
+    (uint64_t)( sim->ipt_mask + 1 ) * sizeof(int);
+}
+
+
+/**********************************************************************
+
+    Function    : ipt_hash
+    Description : hash anchor of a process's page
+    Inputs      : pid - process id
+                  page - page number
+    Outputs     : index into the anchor table
+
+***********************************************************************/
+
+static inline unsigned int ipt_hash( int pid, vpn_t page )
+{
+  uint64_t h = ( page ^ ((uint64_t)pid << 48 )) * 0x9E3779B97F4A7C15ULL;
+
+  return ( h >> 32 ) & sim->ipt_mask;
+}
+
+
+/**********************************************************************
+
+    Function    : ipt_lookup
+    Description : find the entry of a resident page
+    Inputs      : pid - process id
+                  page - page number
+                  probes - if not NULL, add the anchor and chain entries read
+    Outputs     : page table entry, or NULL if the page is not resident
+
+***********************************************************************/
+
+ptentry_t *ipt_lookup( int pid, vpn_t page, int *probes )
+{
+  int i = sim->ipt_anchor[ipt_hash( pid, page )];
+  int n = 1;
+
+  for ( ; i >= 0; i = sim->ipt[i].next, n++ ) {
+    if (( sim->ipt[i].pte.number == page ) && ( sim->ipt[i].pid == pid ))
+      break;
+  }
+
+  if ( probes )
+    *probes += n;
+
+  return ( i >= 0 ) ? &sim->ipt[i].pte : NULL;
+}
+
+
+/**********************************************************************
+
+    Function    : ipt_insert
+    Description : make a frame's entry map a process's page
+    Inputs      : pid - process id
+                  page - page number
+                  frame - frame number (its entry must be unused)
+    Outputs     : the (cleared) page table entry
+
+***********************************************************************/
+
+ptentry_t *ipt_insert( int pid, vpn_t page, int frame )
+{
+  ipt_entry_t *e = &sim->ipt[frame];
+  unsigned int h = ipt_hash( pid, page );
+
+  assert( e->pid < 0 );
+
+  memset( &e->pte, 0, sizeof(ptentry_t) );
+  e->pte.number = page;
+  e->pte.frame = frame;
+  e->pid = pid;
+  e->next = sim->ipt_anchor[h];
+  sim->ipt_anchor[h] = frame;
+
+  return &e->pte;
+}
+
+
+/**********************************************************************
+
+    Function    : ipt_remove
+    Description : unlink a frame's entry from its hash chain
+    Inputs      : frame - frame number
+    Outputs     : 0 if successful, -1 if the entry is unused
+
+***********************************************************************/
+
+int ipt_remove( int frame )
+{
+  ipt_entry_t *e = &sim->ipt[frame];
+  int *link;
+
+  if ( e->pid < 0 )
+    return -1;
+
+  for ( link = &sim->ipt_anchor[ipt_hash( e->pid, e->pte.number )]; *link != frame;
+	link = &sim->ipt[*link].next )
+    assert( *link >= 0 );
+
+  *link = e->next;
+  e->pid = -1;
+  e->next = -1;
+
+  return 0;
+}
@@ -36,6 +36,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <unistd.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <sys/types.h>
@@ -49,35 +50,41 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 /* Definitions */
 
-/* second chance list */
+/* resident pages in frequency buckets -- see cmsc312-p2-freq.c; each
+   simulated machine keeps its own as sim->repl */
 
-typedef struct lfu_entry{  
-  int pid;
-  ptentry_t *ptentry;
-  struct lfu_entry *next;
-  struct lfu_entry *prev;
-} lfu_entry_t;
+/**********************************************************************
+
+    Function    : init_lfu
+    Description : initialize lfu buckets (under local replacement, a
+                  process's share the machine's frame map and pools)
+    Inputs      : tr - input trace
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
 
-typedef struct lfu{
-  lfu_entry_t *first;
-} lfu_t;
+int init_lfu( trace_t *tr )
+{
+  if ( sim->repl )
+    sim->repl = freq_share( (freq_t *)sim->repl );
+  else
+    sim->repl = freq_create( sim->frames );
+  return ( sim->repl == NULL ) ? -1 : 0;
+}
 
-lfu_t *page_list;
 
 /**********************************************************************
 
-    Function    : init_lfu
-    Description : initialize lfu list
-    Inputs      : fp - input file of data
-    Outputs     : 0 if successful, -1 otherwise
+    Function    : exit_lfu
+    Description : free the lfu's frequency buckets
+    Inputs      : none
+    Outputs     : none
 
 ***********************************************************************/
 
-int init_lfu( FILE *fp )
+void exit_lfu( void )
 {
-  page_list = (lfu_t *)malloc(sizeof(lfu_t));
-  page_list->first = NULL;
-  return 0;
+  freq_destroy( (freq_t *)sim->repl );
 }
 
 
@@ -85,7 +92,10 @@ int init_lfu( FILE *fp )
 
     Function    : replace_lfu
     Description : choose victim based on lfu algorithm, take the frame 
-                  associated the page with the smallest count as victim 
+                  associated the page with the smallest count as victim.
+                  Ties go to the page that reached that count first, so
+                  runs are reproducible.  O(1): the lowest bucket's
+                  oldest page
     Inputs      : pid - process id of victim frame 
                   victim - frame assigned from fifo -- to be replaced
     Outputs     : 0 if successful, -1 otherwise
@@ -95,31 +105,21 @@ int init_lfu( FILE *fp )
 int replace_lfu( int *pid, frame_t **victim )
 {
   /* Task 3 */
-  lfu_entry_t *current = page_list->first;
-  lfu_entry_t *least_count = current;
-  while(current->next){
-    current = current->next;
-    if(current->ptentry->ct < least_count->ptentry->ct){
-      least_count = current;
-    }
-  }
-
-  // Remove least_count from the linked list
-  if(least_count->next){
-    least_count->next->prev = least_count->prev;
-  }
-  if(least_count->prev){
-    least_count->prev->next = least_count->next;
-  } else{
-    page_list->first = least_count->next;
-  }
+  freq_t *page_list = (freq_t *)sim->repl;
+  freq_node_t *least_count = freq_min( page_list );
+  int frame;
+
+  if ( least_count == NULL )
+    return -1;
 
   // Set victim to the frame given by the frame value of least_counts's ptentry
-  *victim = &(physical_mem[least_count->ptentry->frame]);
+  frame = least_count->ptentry->frame;
+  *victim = &(sim->physical_mem[frame]);
   *pid = least_count->pid;
-  free(least_count);
 
-  printf("replace_lfu: Selected frame %i for replacement\n", least_count->ptentry->frame);
+  EVENT( LOG_FAULTS, EV_VICTIM, least_count->pid, least_count->ptentry->number, frame, 0 );
+  freq_remove( page_list, frame );
+
   return 0;
 }
 
@@ -127,9 +127,8 @@ int replace_lfu( int *pid, frame_t **victim )
 /**********************************************************************
 
     Function    : update_lfu
-    Description : create container for the newly allocated frame (and 
-                  associated page), and insert it to the end (with respect
-                  to page_list->first) of page list 
+    Description : start tracking the newly allocated frame (and 
+                  associated page) in the count 0 bucket
     Inputs      : pid - process id
                   f - frame
     Outputs     : 0 if successful, -1 otherwise
@@ -139,25 +138,42 @@ int replace_lfu( int *pid, frame_t **victim )
 int update_lfu( int pid, frame_t *f )
 {
   /* Task 3 */
-  // Make new list entry
-  lfu_entry_t *list_entry = ( lfu_entry_t *)malloc(sizeof(lfu_entry_t));
-  list_entry->pid = pid;
-  list_entry->ptentry = &(processes[pid].pagetable[f->page]);
-  list_entry->next = NULL;
-  list_entry->prev = NULL;
-
-  // If the page list has items, put this one at the end
-  if(page_list->first){
-    lfu_entry_t *last = page_list->first;
-    while(last->next){
-      last = last->next;
-    }
-    last->next = list_entry;
-    list_entry->prev = last;
-  }
-  else{ // Else put this one as first
-    page_list->first = list_entry;
-  }
-  
+  freq_t *page_list = (freq_t *)sim->repl;
+  return freq_insert( page_list, pid, pt_lookup( pid, f->page, 0, NULL ), f->number );
+}
+
+
+/**********************************************************************
+
+    Function    : ref_lfu
+    Description : the page in frame f was referenced (its ct was bumped):
+                  move it up one bucket
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int ref_lfu( int pid, frame_t *f )
+{
+  freq_t *page_list = (freq_t *)sim->repl;
+  return freq_touch( page_list, f->number );
+}
+
+
+/**********************************************************************
+
+    Function    : release_lfu
+    Description : the page in frame f was swapped out with its process:
+                  stop tracking the frame
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int release_lfu( int pid, frame_t *f )
+{
+  freq_remove( (freq_t *)sim->repl, f->number );
   return 0;
 }
@@ -0,0 +1,426 @@
+/**********************************************************************
+
+   File          : cmsc312-p2-lirs.c
+
+   Description   : This is LIRS, low inter-reference recency set (Jiang
+                   and Zhang).  Pages whose last two references were
+                   close together (LIR) keep most of the frames; the
+                   rest (HIR) rotate through a small queue q.  The stack
+                   s orders pages by recency, including HIR pages no
+                   longer resident, so that a page referenced again while
+                   still on s has a shorter reuse distance than the
+                   oldest LIR page and takes its place.  s is pruned so
+                   that its bottom is always LIR
+                   (see .h for applications)
+
+***********************************************************************/
+/**********************************************************************
+Copyright (c) 2016 The Pennsylvania State University
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of The Pennsylvania State University nor the names of its contributors may be used to endorse or promote products derived from this softwiare without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* Include Files */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <assert.h>
+
+/* Project Include Files */
+#include "cmsc312-p2.h"
+
+/* Definitions */
+
+#define LIRS_LIR      0       /* resident, in the low reuse-distance set */
+#define LIRS_HIR      1       /* resident, on q */
+#define LIRS_GONE     2       /* not resident, still on s */
+
+/* LIR pages wanted, all but 1% of the frames managed, and the
+   non-resident entries kept on s (see local_frames) */
+#define LIRS_LLIRS( c )     (( c ) - ((( c ) / 100 > 1 ) ? ( c ) / 100 : 1 ))
+#define LIRS_MAX_GONE( c )  ( 2 * ( c ))
+
+typedef struct lirs {
+  qlist_t s;                  /* recency stack over entries: head is the top */
+  qlist_t q;                  /* resident HIR entries: tail is the next victim */
+  qlist_t gone;               /* non-resident HIR entries, oldest at the tail */
+  qdir_t dir;
+  int *state;                 /* state of each entry */
+  int *frame;                 /* frame of each resident entry */
+  int *entry;                 /* entry of the page in each frame, if tracked */
+  uint64_t *fresh;            /* frames not referenced since their page came in */
+  int lir;                    /* LIR pages now */
+  int shared;                 /* the frame arrays are the machine's first state's */
+} lirs_t;
+
+/* each simulated machine keeps its own stack and queue as sim->repl */
+
+
+/**********************************************************************
+
+    Function    : lirs_prune
+    Description : pop HIR entries off the bottom of s until it is LIR,
+                  forgetting those that are not resident
+    Inputs      : l - lirs state
+    Outputs     : none
+
+***********************************************************************/
+
+static void lirs_prune( lirs_t *l )
+{
+  int e;
+
+  while ((( e = l->s.tail ) != QLIST_NONE ) && ( l->state[e] != LIRS_LIR )) {
+    qlist_remove( &l->s, e );
+    if ( l->state[e] == LIRS_GONE ) {
+      qlist_remove( &l->gone, e );
+      qdir_del( &l->dir, e );
+    }
+  }
+}
+
+
+/**********************************************************************
+
+    Function    : lirs_demote
+    Description : the bottom LIR page of s becomes a resident HIR page
+    Inputs      : l - lirs state
+    Outputs     : none
+
+***********************************************************************/
+
+static void lirs_demote( lirs_t *l )
+{
+  int b;
+
+  lirs_prune( l );            /* with no LIR pages (one frame) s was not pruned */
+  b = l->s.tail;
+  qlist_remove( &l->s, b );
+  l->state[b] = LIRS_HIR;
+  qlist_push( &l->q, b );
+  l->lir--;
+  lirs_prune( l );
+}
+
+
+/**********************************************************************
+
+    Function    : lirs_promote
+    Description : make an entry the top LIR page, demoting the bottom
+                  LIR page to q if there are now too many
+    Inputs      : l - lirs state
+                  e - entry, resident
+    Outputs     : none
+
+***********************************************************************/
+
+static void lirs_promote( lirs_t *l, int e )
+{
+
+  if ( qlist_on( &l->s, e ))
+    qlist_remove( &l->s, e );
+  qlist_push( &l->s, e );
+  l->state[e] = LIRS_LIR;
+  l->lir++;
+
+  if ( l->lir > LIRS_LLIRS( local_frames( )))
+    lirs_demote( l );
+}
+
+
+/**********************************************************************
+
+    Function    : lirs_room
+    Description : make sure the directory has a free entry, growing it,
+                  the lists over its entries and their state
+    Inputs      : l - lirs state
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+static int lirs_room( lirs_t *l )
+{
+  qlist_t *lists[3] = { &l->s, &l->q, &l->gone };
+  int old = l->dir.n, *state, *frame;
+
+  if ( qdir_room( &l->dir, lists, 3 ))
+    return -1;
+  if ( l->dir.n == old )
+    return 0;
+
+  if (( state = (int *)realloc( l->state, sizeof(int) * l->dir.n )) != NULL )
+    l->state = state;
+  if (( frame = (int *)realloc( l->frame, sizeof(int) * l->dir.n )) != NULL )
+    l->frame = frame;
+
+  return (( state == NULL ) || ( frame == NULL )) ? -1 : 0;
+}
+
+
+/**********************************************************************
+
+    Function    : init_lirs
+    Description : initialize an empty stack and queue, keeping up to
+                  twice as many non-resident pages as frames (a
+                  process's state under local replacement shares the
+                  frame arrays of the machine's, and its directory
+                  grows as pages come)
+    Inputs      : tr - input trace
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int init_lirs( trace_t *tr )
+{
+  lirs_t *model = (lirs_t *)sim->repl;
+  lirs_t *l = (lirs_t *)calloc( 1, sizeof(lirs_t) );
+  int c = sim->frames, n, i;
+
+  if (( sim->repl = l ) == NULL )
+    return -1;
+
+  n = c + LIRS_MAX_GONE( c ) + 1;
+
+  if ( model ) {
+    l->shared = 1;
+    l->entry = model->entry;
+    l->fresh = model->fresh;
+    n = ( n > QDIR_MIN ) ? QDIR_MIN : n;
+  }
+  else {
+    l->entry = (int *)malloc( sizeof(int) * c );
+    l->fresh = (uint64_t *)calloc( BITMAP_WORDS( c ), sizeof(uint64_t) );
+    if (( l->entry == NULL ) || ( l->fresh == NULL ))
+      return -1;
+    for ( i = 0; i < c; i++ )
+      l->entry[i] = QLIST_NONE;
+  }
+
+  l->state = (int *)calloc( n, sizeof(int) );
+  l->frame = (int *)calloc( n, sizeof(int) );
+
+  if (( l->state == NULL ) || ( l->frame == NULL ) ||
+      qdir_init( &l->dir, n ) || qlist_init( &l->s, n ) ||
+      qlist_init( &l->q, n ) || qlist_init( &l->gone, n ))
+    return -1;
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : exit_lirs
+    Description : free the stack and queue
+    Inputs      : none
+    Outputs     : none
+
+***********************************************************************/
+
+void exit_lirs( void )
+{
+  lirs_t *l = (lirs_t *)sim->repl;
+
+  qlist_free( &l->s );
+  qlist_free( &l->q );
+  qlist_free( &l->gone );
+  qdir_free( &l->dir );
+  free( l->state );
+  free( l->frame );
+  if ( !l->shared ) {
+    free( l->entry );
+    free( l->fresh );
+  }
+  free( l );
+}
+
+
+/**********************************************************************
+
+    Function    : replace_lirs
+    Description : the front resident HIR page of q; it stays on s as
+                  non-resident if it is there
+    Inputs      : pid - process id of victim frame 
+                  victim - frame assignment 
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int replace_lirs( int *pid, frame_t **victim )
+{
+  lirs_t *l = (lirs_t *)sim->repl;
+  int c = local_frames( ), e, old, frame;
+
+  /* a quota that shrank leaves too many LIR pages: the bottom ones go
+     to q, and with every resident page LIR the bottom one goes */
+  while ( l->lir && (( l->lir > LIRS_LLIRS( c )) || ( l->q.len == 0 )))
+    lirs_demote( l );
+
+  if (( e = l->q.tail ) == QLIST_NONE )
+    return -1;
+  qlist_remove( &l->q, e );
+  frame = l->frame[e];
+  l->entry[frame] = QLIST_NONE;
+
+  *victim = &(sim->physical_mem[frame]);
+  *pid = l->dir.pid[e];
+
+  if ( qlist_on( &l->s, e )) {
+    l->state[e] = LIRS_GONE;
+    qlist_push( &l->gone, e );
+
+    // Bound the non-resident entries: the oldest leave s
+    while ( l->gone.len > LIRS_MAX_GONE( c )) {
+      old = l->gone.tail;
+      qlist_remove( &l->gone, old );
+      qlist_remove( &l->s, old );
+      qdir_del( &l->dir, old );
+    }
+  }
+  else
+    qdir_del( &l->dir, e );
+
+  EVENT( LOG_FAULTS, EV_VICTIM, *pid, sim->physical_mem[frame].page, frame, 0 );
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : update_lirs
+    Description : a page was loaded into a frame: LIR while there is
+                  room or if it was still on s, else a HIR page on q
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int update_lirs( int pid, frame_t *f )
+{
+  lirs_t *l = (lirs_t *)sim->repl;
+  int e = qdir_find( &l->dir, pid, f->page );
+
+  if ( e != QLIST_NONE )
+    qlist_remove( &l->gone, e );
+  else if ( lirs_room( l ) || (( e = qdir_add( &l->dir, pid, f->page )) == QLIST_NONE ))
+    return -1;
+
+  l->frame[e] = f->number;
+  l->entry[f->number] = e;
+  BITMAP_SET( l->fresh, f->number );
+
+  if ( qlist_on( &l->s, e ) || ( l->lir < LIRS_LLIRS( local_frames( ))))
+    lirs_promote( l, e );
+  else {
+    l->state[e] = LIRS_HIR;
+    qlist_push( &l->s, e );
+    qlist_push( &l->q, e );
+  }
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : ref_lirs
+    Description : a resident page was referenced again: to the top of
+                  s, and a HIR page still on s becomes LIR (the access
+                  that faulted it in does not count)
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int ref_lirs( int pid, frame_t *f )
+{
+  lirs_t *l = (lirs_t *)sim->repl;
+  int e = l->entry[f->number];
+  int bottom;
+
+  if ( BITMAP_TEST( l->fresh, f->number )) {
+    BITMAP_CLEAR( l->fresh, f->number );
+    return 0;
+  }
+
+  if ( l->state[e] == LIRS_LIR ) {
+    bottom = ( l->s.tail == e );
+    qlist_remove( &l->s, e );
+    qlist_push( &l->s, e );
+    if ( bottom )
+      lirs_prune( l );
+    return 0;
+  }
+
+  qlist_remove( &l->q, e );
+
+  if ( qlist_on( &l->s, e )) {
+    lirs_promote( l, e );
+    return 0;
+  }
+
+  qlist_push( &l->s, e );
+  qlist_push( &l->q, e );
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : release_lirs
+    Description : the page in frame f was swapped out with its process:
+                  forget it, LIR or HIR, and prune s
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int release_lirs( int pid, frame_t *f )
+{
+  lirs_t *l = (lirs_t *)sim->repl;
+  int e = l->entry[f->number];
+
+  /* already given up by replacement (local replacement releases every victim) */
+  if ( e == QLIST_NONE )
+    return 0;
+  l->entry[f->number] = QLIST_NONE;
+  BITMAP_CLEAR( l->fresh, f->number );
+
+  if ( l->state[e] == LIRS_LIR )
+    l->lir--;
+  else
+    qlist_remove( &l->q, e );
+
+  if ( qlist_on( &l->s, e ))
+    qlist_remove( &l->s, e );
+  qdir_del( &l->dir, e );
+  lirs_prune( l );
+
+  return 0;
+}
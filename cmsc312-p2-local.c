@@ -0,0 +1,459 @@
+/**********************************************************************
+
+   File          : cmsc312-p2-local.c
+
+   Description   : Local replacement: each process may hold up to a
+                   quota of frames, and a fault replaces one of its own
+                   pages once it is there.  Quotas split the frames
+                   equally among the processes seen so far, or in
+                   proportion to their working sets, or start equal and
+                   shrink for processes faulting under pff_low percent
+                   of their references, the frames given up going to
+                   those faulting over pff_high.  A process
+                   under its quota with no frame free takes one from the
+                   process furthest over its own
+                   (see .h for applications)
+
+***********************************************************************/
+/**********************************************************************
+Copyright (c) 2016 The Pennsylvania State University
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of The Pennsylvania State University nor the names of its contributors may be used to endorse or promote products derived from this softwiare without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* Include Files */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <assert.h>
+
+/* Project Include Files */
+#include "cmsc312-p2.h"
+
+/* Definitions */
+
+
+/**********************************************************************
+
+    Function    : local_init
+    Description : make the heap of processes holding frames and the
+                  scratch weights the quotas are split by
+    Inputs      : none
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int local_init( void )
+{
+  int i;
+
+  sim->local_heap = (int *)malloc( sizeof(int) * max_processes );
+  sim->local_pos = (int *)malloc( sizeof(int) * max_processes );
+  sim->local_weight = (uint64_t *)calloc( max_processes, sizeof(uint64_t) );
+  sim->local_count = 0;
+
+  if (( sim->local_heap == NULL ) || ( sim->local_pos == NULL ) || ( sim->local_weight == NULL ))
+    return -1;
+
+  for ( i = 0; i < max_processes; i++ )
+    sim->local_pos[i] = -1;
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : local_exit
+    Description : free the heap and scratch weights
+    Inputs      : none
+    Outputs     : none
+
+***********************************************************************/
+
+void local_exit( void )
+{
+  free( sim->local_heap );
+  free( sim->local_pos );
+  free( sim->local_weight );
+  sim->local_heap = sim->local_pos = NULL;
+  sim->local_weight = NULL;
+}
+
+
+/**********************************************************************
+
+    Function    : local_before
+    Description : does one process give up a frame before another:
+                  further over its quota, or as far and a lower pid
+    Inputs      : a, b - process ids
+    Outputs     : 1 if a comes first, 0 otherwise
+
+***********************************************************************/
+
+static int local_before( int a, int b )
+{
+  int over_a = sim->processes[a].frames - sim->processes[a].quota;
+  int over_b = sim->processes[b].frames - sim->processes[b].quota;
+
+  return ( over_a > over_b ) || (( over_a == over_b ) && ( a < b ));
+}
+
+
+/**********************************************************************
+
+    Function    : local_place
+    Description : put a process at a heap slot, noting where
+    Inputs      : i - heap slot
+                  pid - process id
+    Outputs     : none
+
+***********************************************************************/
+
+static void local_place( int i, int pid )
+{
+  sim->local_heap[i] = pid;
+  sim->local_pos[pid] = i;
+}
+
+
+/**********************************************************************
+
+    Function    : local_sift
+    Description : move the process at a heap slot up or down to where
+                  it belongs
+    Inputs      : i - heap slot
+    Outputs     : none
+
+***********************************************************************/
+
+static void local_sift( int i )
+{
+  int *h = sim->local_heap;
+  int pid = h[i], c;
+
+  while (( i > 0 ) && local_before( pid, h[( i - 1 ) / 2] )) {
+    local_place( i, h[( i - 1 ) / 2] );
+    i = ( i - 1 ) / 2;
+  }
+
+  while (( c = 2 * i + 1 ) < sim->local_count ) {
+    if (( c + 1 < sim->local_count ) && local_before( h[c + 1], h[c] ))
+      c++;
+    if ( !local_before( h[c], pid ))
+      break;
+    local_place( i, h[c] );
+    i = c;
+  }
+
+  local_place( i, pid );
+}
+
+
+/**********************************************************************
+
+    Function    : local_moved
+    Description : a process took or gave up a frame: enter it in the
+                  heap, drop it from there, or move it
+    Inputs      : pid - process id
+    Outputs     : none
+
+***********************************************************************/
+
+void local_moved( int pid )
+{
+  int i = sim->local_pos[pid], last;
+
+  if ( sim->processes[pid].frames == 0 ) {
+    if ( i < 0 )
+      return;
+    sim->local_pos[pid] = -1;
+    last = sim->local_heap[--sim->local_count];
+    if ( last != pid ) {
+      local_place( i, last );
+      local_sift( i );
+    }
+    return;
+  }
+
+  if ( i < 0 ) {
+    i = sim->local_count++;
+    local_place( i, pid );
+  }
+  local_sift( i );
+}
+
+
+/**********************************************************************
+
+    Function    : local_order
+    Description : reorder the heap after the quotas changed, each
+                  process in it rising to its place in turn
+    Inputs      : none
+    Outputs     : none
+
+***********************************************************************/
+
+static void local_order( void )
+{
+  int i, n = sim->local_count;
+
+  /* enter them again one at a time */
+  for ( i = 0; i < n; i++ ) {
+    sim->local_count = i + 1;
+    local_sift( i );
+  }
+}
+
+
+/**********************************************************************
+
+    Function    : local_split
+    Description : set the quotas in proportion to weights, handing out
+                  the frames left by rounding down one at a time
+    Inputs      : weight - weight of each process (0 if not created)
+    Outputs     : none
+
+***********************************************************************/
+
+static void local_split( uint64_t *weight )
+{
+  uint64_t total = 0;
+  int i, left = sim->frames;
+
+  for ( i = 0; i < max_processes; i++ )
+    total += weight[i];
+
+  if ( total == 0 )
+    return;
+
+  for ( i = 0; i < max_processes; i++ ) {
+    if ( weight[i] ) {
+      sim->processes[i].quota = (int)(( weight[i] * sim->frames ) / total );
+      left -= sim->processes[i].quota;
+    }
+  }
+
+  for ( i = 0; ( left > 0 ) && ( i < max_processes ); i = ( i + 1 ) % max_processes ) {
+    if ( weight[i] ) {
+      sim->processes[i].quota++;
+      left--;
+    }
+  }
+
+  /* even a process with a tiny share may hold a page */
+  for ( i = 0; i < max_processes; i++ ) {
+    if ( weight[i] && ( sim->processes[i].quota == 0 ))
+      sim->processes[i].quota = 1;
+  }
+}
+
+
+/**********************************************************************
+
+    Function    : local_rebalance
+    Description : split the frames equally among the processes seen so
+                  far (a process arrived)
+    Inputs      : none
+    Outputs     : none
+
+***********************************************************************/
+
+void local_rebalance( void )
+{
+  int i;
+
+  for ( i = 0; i < max_processes; i++ )
+    sim->local_weight[i] = sim->processes[i].created;
+
+  local_split( sim->local_weight );
+  local_order( );
+}
+
+
+/**********************************************************************
+
+    Function    : local_adjust
+    Description : revisit the quotas (once a window): in proportion to
+                  the working sets now, or by each process's fault rate
+                  over the window -- shrunk by a quarter if low, and
+                  grown by a quarter, as far as the frames no quota
+                  holds allow, if high
+    Inputs      : none
+    Outputs     : none
+
+***********************************************************************/
+
+void local_adjust( void )
+{
+  uint64_t *weight = sim->local_weight;
+  task_t *t;
+  uint64_t refs;
+  int i, step, spare = sim->frames;
+
+  if ( local_quota == LOCAL_PROP ) {
+    for ( i = 0; i < max_processes; i++ ) {
+      weight[i] = 0;
+      if ( sim->processes[i].created )
+	weight[i] = sim->ws[i].size ? sim->ws[i].size : 1;
+    }
+    local_split( weight );
+    local_order( );
+    return;
+  }
+
+  /* shrink first, so the frames given up can go to those faulting */
+  for ( i = 0; i < max_processes; i++ ) {
+    t = &sim->processes[i];
+    if ( !t->created )
+      continue;
+    refs = t->ct - t->ct_mark;
+    step = ( t->quota > 4 ) ? t->quota / 4 : 1;
+    if ((( t->pfs - t->pfs_mark ) * 100 < pff_low * refs ) && ( t->quota > 1 ))
+      t->quota -= step;
+    spare -= t->quota;
+  }
+
+  for ( i = 0; i < max_processes; i++ ) {
+    t = &sim->processes[i];
+    if ( !t->created )
+      continue;
+    refs = t->ct - t->ct_mark;
+    step = ( t->quota > 4 ) ? t->quota / 4 : 1;
+    if ( step > spare )
+      step = spare;
+    if ((( t->pfs - t->pfs_mark ) * 100 > pff_high * refs ) && ( step > 0 )) {
+      t->quota += step;
+      spare -= step;
+    }
+
+    t->ct_mark = t->ct;
+    t->pfs_mark = t->pfs;
+  }
+
+  local_order( );
+}
+
+
+/**********************************************************************
+
+    Function    : local_full
+    Description : is a process at its quota, so that it replaces its
+                  own pages even if frames are free
+    Inputs      : pid - process id
+    Outputs     : 1 if so, 0 if it may take a free frame
+
+***********************************************************************/
+
+int local_full( int pid )
+{
+  task_t *t = &sim->processes[pid];
+
+  return ( t->frames > 0 ) && ( t->frames >= t->quota );
+}
+
+
+/**********************************************************************
+
+    Function    : local_frames
+    Description : frames the current replacement state manages, which
+                  its mechanism sizes its lists and targets by: the
+                  quota of its process, or every frame under global
+                  replacement (read at each decision, so quotas that
+                  change take effect at once)
+    Inputs      : none
+    Outputs     : frame count, at least 1
+
+***********************************************************************/
+
+int local_frames( void )
+{
+  int quota;
+
+  if ( !local_quota )
+    return sim->frames;
+
+  quota = sim->processes[sim->repl_pid].quota;
+  return ( quota > 0 ) ? quota : 1;
+}
+
+
+/**********************************************************************
+
+    Function    : local_owner
+    Description : whose page a fault replaces: the faulting process's
+                  own at its quota, else the process furthest over (or
+                  least under) its quota among those holding frames
+    Inputs      : pid - faulting process id
+    Outputs     : process id, or -1 if no process holds a frame
+
+***********************************************************************/
+
+int local_owner( int pid )
+{
+  int *h = sim->local_heap;
+  int i, owner;
+
+  if ( local_full( pid ))
+    return pid;
+
+  /* nobody holds a frame */
+  if ( sim->local_count == 0 )
+    return -1;
+
+  if ( h[0] != pid )
+    return h[0];
+
+  /* it is furthest over itself: the better of its heap children */
+  owner = -1;
+  for ( i = 1; ( i <= 2 ) && ( i < sim->local_count ); i++ ) {
+    if (( owner < 0 ) || local_before( h[i], owner ))
+      owner = h[i];
+  }
+
+  /* nobody else holds a frame: its own */
+  return ( owner < 0 ) ? pid : owner;
+}
+
+
+/**********************************************************************
+
+    Function    : local_mode
+    Description : describe the replacement scope, for the results
+    Inputs      : none
+    Outputs     : text
+
+***********************************************************************/
+
+const char *local_mode( void )
+{
+  static const char *modes[] = { "global",
+				 "local, equal quotas",
+				 "local, quotas in proportion to working sets",
+				 "local, quotas adapted to page-fault frequency" };
+
+  return modes[local_quota];
+}
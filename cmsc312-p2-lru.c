@@ -0,0 +1,263 @@
+/**********************************************************************
+
+   File          : cmsc312-p2-lru.c
+
+   Description   : This is least recently used page replacement.  The
+                   resident frames are on a doubly linked list in
+                   recency order, linked through arrays indexed by frame
+                   number, so a reference moves its frame to the front
+                   and the victim is taken from the back, both O(1)
+                   (see .h for applications)
+
+***********************************************************************/
+/**********************************************************************
+Copyright (c) 2016 The Pennsylvania State University
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of The Pennsylvania State University nor the names of its contributors may be used to endorse or promote products derived from this softwiare without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* Include Files */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <assert.h>
+
+/* Project Include Files */
+#include "cmsc312-p2.h"
+
+/* Definitions */
+#define LRU_NONE  -1
+
+typedef struct lru {
+  int *prev;                  /* toward the most recently used, per frame */
+  int *next;                  /* toward the least recently used */
+  int *pid;                   /* process owning the page in each frame */
+  int mru;
+  int lru;
+  int shared;                 /* the frame arrays are the machine's first state's */
+} lru_t;
+
+/* each simulated machine keeps its own list as sim->repl */
+
+
+/**********************************************************************
+
+    Function    : lru_touch
+    Description : move a frame to the most recently used end, linking
+                  it in if it is not on the list yet
+    Inputs      : l - lru state
+                  frame - frame number
+    Outputs     : none
+
+***********************************************************************/
+
+static inline void lru_touch( lru_t *l, int frame )
+{
+  if ( l->mru == frame )
+    return;
+
+  /* unlink, if linked: only the MRU frame has no prev */
+  if ( l->prev[frame] != LRU_NONE ) {
+    l->next[l->prev[frame]] = l->next[frame];
+    if ( l->next[frame] != LRU_NONE )
+      l->prev[l->next[frame]] = l->prev[frame];
+    else
+      l->lru = l->prev[frame];
+  }
+
+  l->prev[frame] = LRU_NONE;
+  l->next[frame] = l->mru;
+  if ( l->mru != LRU_NONE )
+    l->prev[l->mru] = frame;
+  else
+    l->lru = frame;
+  l->mru = frame;
+}
+
+
+/**********************************************************************
+
+    Function    : init_lru
+    Description : initialize an empty recency list (under local
+                  replacement, a process's links its frames through the
+                  machine's arrays: a frame is on one list at most)
+    Inputs      : tr - input trace
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int init_lru( trace_t *tr )
+{
+  lru_t *model = (lru_t *)sim->repl;
+  lru_t *l = (lru_t *)malloc( sizeof(lru_t) );
+  int i;
+
+  if (( sim->repl = l ) == NULL )
+    return -1;
+
+  l->mru = l->lru = LRU_NONE;
+  l->shared = ( model != NULL );
+  if ( model ) {
+    l->prev = model->prev;
+    l->next = model->next;
+    l->pid = model->pid;
+    return 0;
+  }
+
+  l->prev = (int *)malloc( sizeof(int) * sim->frames );
+  l->next = (int *)malloc( sizeof(int) * sim->frames );
+  l->pid = (int *)calloc( sim->frames, sizeof(int) );
+
+  if (( l->prev == NULL ) || ( l->next == NULL ) || ( l->pid == NULL ))
+    return -1;
+
+  for ( i = 0; i < sim->frames; i++ )
+    l->prev[i] = l->next[i] = LRU_NONE;
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : exit_lru
+    Description : free the recency list
+    Inputs      : none
+    Outputs     : none
+
+***********************************************************************/
+
+void exit_lru( void )
+{
+  lru_t *l = (lru_t *)sim->repl;
+
+  if ( !l->shared ) {
+    free( l->prev );
+    free( l->next );
+    free( l->pid );
+  }
+  free( l );
+}
+
+
+/**********************************************************************
+
+    Function    : replace_lru
+    Description : choose the least recently used frame
+    Inputs      : pid - process id of victim frame 
+                  victim - frame assignment 
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int replace_lru( int *pid, frame_t **victim )
+{
+  lru_t *l = (lru_t *)sim->repl;
+
+  if ( l->lru == LRU_NONE )
+    return -1;
+
+  // The frame stays linked: the page faulting in moves it to the front
+  *victim = &(sim->physical_mem[l->lru]);
+  *pid = l->pid[l->lru];
+
+  EVENT( LOG_FAULTS, EV_VICTIM, *pid, sim->physical_mem[l->lru].page, l->lru, 0 );
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : update_lru
+    Description : a page was loaded into a frame: most recently used
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int update_lru( int pid, frame_t *f )
+{
+  lru_t *l = (lru_t *)sim->repl;
+
+  l->pid[f->number] = pid;
+  lru_touch( l, f->number );
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : ref_lru
+    Description : a resident page was referenced: most recently used
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int ref_lru( int pid, frame_t *f )
+{
+  lru_touch( (lru_t *)sim->repl, f->number );
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : release_lru
+    Description : the page in frame f was swapped out with its process:
+                  unlink the frame
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int release_lru( int pid, frame_t *f )
+{
+  lru_t *l = (lru_t *)sim->repl;
+  int frame = f->number;
+
+  /* linked if it has a prev, or is the MRU frame */
+  if (( l->prev[frame] == LRU_NONE ) && ( l->mru != frame ))
+    return 0;
+
+  if ( l->prev[frame] != LRU_NONE )
+    l->next[l->prev[frame]] = l->next[frame];
+  else
+    l->mru = l->next[frame];
+
+  if ( l->next[frame] != LRU_NONE )
+    l->prev[l->next[frame]] = l->prev[frame];
+  else
+    l->lru = l->prev[frame];
+
+  l->prev[frame] = LRU_NONE;
+  l->next[frame] = LRU_NONE;
+  return 0;
+}
@@ -36,6 +36,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <unistd.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <sys/types.h>
@@ -49,35 +50,41 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 /* Definitions */
 
-/* second chance list */
+/* resident pages in frequency buckets -- see cmsc312-p2-freq.c; each
+   simulated machine keeps its own as sim->repl */
 
-typedef struct mfu_entry{  
-  int pid;
-  ptentry_t *ptentry;
-  struct mfu_entry *next;
-  struct mfu_entry *prev;
-} mfu_entry_t;
+/**********************************************************************
+
+    Function    : init_mfu
+    Description : initialize mfu buckets (under local replacement, a
+                  process's share the machine's frame map and pools)
+    Inputs      : tr - input trace
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
 
-typedef struct mfu{
-  mfu_entry_t *first;
-} mfu_t;
+int init_mfu( trace_t *tr )
+{
+  if ( sim->repl )
+    sim->repl = freq_share( (freq_t *)sim->repl );
+  else
+    sim->repl = freq_create( sim->frames );
+  return ( sim->repl == NULL ) ? -1 : 0;
+}
 
-mfu_t *page_list;
 
 /**********************************************************************
 
-    Function    : init_mfu
-    Description : initialize mfu list
-    Inputs      : fp - input file of data
-    Outputs     : 0 if successful, -1 otherwise
+    Function    : exit_mfu
+    Description : free the mfu's frequency buckets
+    Inputs      : none
+    Outputs     : none
 
 ***********************************************************************/
 
-int init_mfu( FILE *fp )
+void exit_mfu( void )
 {
-  page_list = (mfu_t *)malloc(sizeof(mfu_t));
-  page_list->first = NULL;
-  return 0;
+  freq_destroy( (freq_t *)sim->repl );
 }
 
 
@@ -85,7 +92,10 @@ int init_mfu( FILE *fp )
 
     Function    : replace_mfu
     Description : choose victim based on mfu algorithm, take the frame 
-                  associated the page with the largest count as victim 
+                  associated the page with the largest count as victim.
+                  The buckets track the highest count, so this is O(1)
+                  whatever the number of resident frames; ties go to the
+                  page that reached that count first
     Inputs      : pid - process id of victim frame 
                   victim - frame assigned from fifo -- to be replaced
     Outputs     : 0 if successful, -1 otherwise
@@ -95,31 +105,21 @@ int init_mfu( FILE *fp )
 int replace_mfu( int *pid, frame_t **victim )
 {
   /* Task 3 */
-  mfu_entry_t *current = page_list->first;
-  mfu_entry_t *most_count = current;
-  while(current->next){
-    current = current->next;
-    if(current->ptentry->ct > most_count->ptentry->ct){
-      most_count = current;
-    }
-  }
-
-  // Remove most_count from the linked list
-  if(most_count->next){
-    most_count->next->prev = most_count->prev;
-  }
-  if(most_count->prev){
-    most_count->prev->next = most_count->next;
-  } else{
-    page_list->first = most_count->next;
-  }
+  freq_t *page_list = (freq_t *)sim->repl;
+  freq_node_t *most_count = freq_max( page_list );
+  int frame;
+
+  if ( most_count == NULL )
+    return -1;
 
   // Set victim to the frame given by the frame value of most_count's ptentry
-  *victim = &(physical_mem[most_count->ptentry->frame]);
+  frame = most_count->ptentry->frame;
+  *victim = &(sim->physical_mem[frame]);
   *pid = most_count->pid;
-  free(most_count);
 
-  printf("replace_mfu: Selected frame %i for replacement\n", most_count->ptentry->frame);
+  EVENT( LOG_FAULTS, EV_VICTIM, most_count->pid, most_count->ptentry->number, frame, 0 );
+  freq_remove( page_list, frame );
+
   return 0;
 }
 
@@ -127,9 +127,8 @@ int replace_mfu( int *pid, frame_t **victim )
 /**********************************************************************
 
     Function    : update_mfu
-    Description : create container for the newly allocated frame (and 
-                  associated page), and insert it to the end (with respect
-                  to page_list->first) of page list 
+    Description : start tracking the newly allocated frame (and 
+                  associated page) in the count 0 bucket
     Inputs      : pid - process id
                   f - frame
     Outputs     : 0 if successful, -1 otherwise
@@ -139,25 +138,42 @@ int replace_mfu( int *pid, frame_t **victim )
 int update_mfu( int pid, frame_t *f )
 {
   /* Task 3 */
-  // Make new list entry
-  mfu_entry_t *list_entry = ( mfu_entry_t *)malloc(sizeof(mfu_entry_t));
-  list_entry->pid = pid;
-  list_entry->ptentry = &(processes[pid].pagetable[f->page]);
-  list_entry->next = NULL;
-  list_entry->prev = NULL;
-
-  // If the page list has items, put this one at the end
-  if(page_list->first){
-    mfu_entry_t *last = page_list->first;
-    while(last->next){
-      last = last->next;
-    }
-    last->next = list_entry;
-    list_entry->prev = last;
-  }
-  else{ // Else put this one as first
-    page_list->first = list_entry;
-  }
-  
+  freq_t *page_list = (freq_t *)sim->repl;
+  return freq_insert( page_list, pid, pt_lookup( pid, f->page, 0, NULL ), f->number );
+}
+
+
+/**********************************************************************
+
+    Function    : ref_mfu
+    Description : the page in frame f was referenced (its ct was bumped):
+                  move it up one bucket, raising the maximum if needed
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int ref_mfu( int pid, frame_t *f )
+{
+  freq_t *page_list = (freq_t *)sim->repl;
+  return freq_touch( page_list, f->number );
+}
+
+
+/**********************************************************************
+
+    Function    : release_mfu
+    Description : the page in frame f was swapped out with its process:
+                  stop tracking the frame
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int release_mfu( int pid, frame_t *f )
+{
+  freq_remove( (freq_t *)sim->repl, f->number );
   return 0;
 }
@@ -0,0 +1,622 @@
+/**********************************************************************
+
+   File          : cmsc312-p2-opt.c
+
+   Description   : This is Belady's optimal page replacement algorithm:
+                   evict the resident page whose next use is farthest
+                   away.  Init reads the trace once to build a next-use
+                   index (for each reference, the number of the next
+                   reference to the same page); the resident frames sit
+                   in a max-heap on their next use
+                   (see .h for applications)
+
+***********************************************************************/
+/**********************************************************************
+Copyright (c) 2016 The Pennsylvania State University
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of The Pennsylvania State University nor the names of its contributors may be used to endorse or promote products derived from this softwiare without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* Include Files */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <assert.h>
+#include <pthread.h>
+
+/* Project Include Files */
+#include "cmsc312-p2.h"
+
+/* Definitions */
+#define OPT_NEVER        UINT32_MAX   /* not referenced again */
+#define OPT_MIN_PAGES    1024
+
+/* references to a page, hashed on (pid, page) */
+typedef struct opt_page {
+  vpn_t page;
+  int pid;                    /* -1 for an empty slot */
+  uint32_t first;
+  uint32_t last;
+  uint32_t count;
+  uint32_t at;                /* where they start in opt_ahead_t.uses */
+} opt_page_t;
+
+/* for readahead: every page's references in trace order, so the next use
+   of a page that is not being referenced can be looked up.  Read-only
+   once built, so it is shared like the next-use index */
+typedef struct opt_ahead {
+  opt_page_t *pages;
+  uint32_t mask;
+  uint32_t *uses;
+} opt_ahead_t;
+
+typedef struct opt {
+  uint32_t *next;             /* next use of the page of each reference */
+  int shared;                 /* next and ahead belong to someone else */
+  uint32_t now;               /* reference being run */
+  uint32_t *key;              /* next use of the page in each frame */
+  int *pid;                   /* process owning the page in each frame */
+  int *heap;                  /* frames, farthest next use on top */
+  int *pos;                   /* heap position of each frame, -1 if none */
+  int size;
+  int room;                   /* frames the heap has room for */
+  int frames_shared;          /* key, pid and pos are the machine's first state's */
+  opt_ahead_t *ahead;         /* page references, for readahead */
+} opt_t;
+
+/* each simulated machine keeps its own heap as sim->repl.  Sweep jobs
+   replay one in-memory trace, so they share its next-use index */
+static pthread_mutex_t opt_lock = PTHREAD_MUTEX_INITIALIZER;
+static const unsigned char *opt_shared_start = NULL;
+static uint32_t *opt_shared_next = NULL;
+static opt_ahead_t *opt_shared_ahead = NULL;
+
+
+/**********************************************************************
+
+    Function    : opt_slot
+    Description : find a page's slot, or the empty slot it would take
+    Inputs      : pages - hash table
+                  mask - table size - 1
+                  pid - process
+                  page - page number
+    Outputs     : slot
+
+***********************************************************************/
+
+static uint32_t opt_slot( opt_page_t *pages, uint32_t mask, int pid, vpn_t page )
+{
+  uint64_t hash = ( page ^ ((uint64_t)pid << 48 )) * 0x9E3779B97F4A7C15ULL;
+  uint32_t h;
+
+  for ( h = ( hash >> 32 ) & mask; pages[h].pid >= 0; h = ( h + 1 ) & mask ) {
+    if (( pages[h].page == page ) && ( pages[h].pid == pid ))
+      break;
+  }
+
+  return h;
+}
+
+
+/**********************************************************************
+
+    Function    : opt_grow
+    Description : double the page hash table
+    Inputs      : pages - hash table (replaced)
+                  mask - table size - 1 (updated)
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+static int opt_grow( opt_page_t **pages, uint32_t *mask )
+{
+  opt_page_t *old = *pages;
+  uint32_t n = *mask + 1, i;
+
+  if (( *pages = (opt_page_t *)malloc( sizeof(opt_page_t) * n * 2 )) == NULL ) {
+    *pages = old;
+    return -1;
+  }
+
+  *mask = n * 2 - 1;
+  for ( i = 0; i < n * 2; i++ )
+    (*pages)[i].pid = -1;
+  for ( i = 0; i < n; i++ ) {
+    if ( old[i].pid >= 0 )
+      (*pages)[opt_slot( *pages, *mask, old[i].pid, old[i].page )] = old[i];
+  }
+
+  free( old );
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : opt_free_ahead
+    Description : free a readahead table
+    Inputs      : a - table, or NULL
+    Outputs     : none
+
+***********************************************************************/
+
+static void opt_free_ahead( opt_ahead_t *a )
+{
+  if ( a == NULL )
+    return;
+
+  free( a->pages );
+  free( a->uses );
+  free( a );
+}
+
+
+/**********************************************************************
+
+    Function    : opt_uses
+    Description : lay out every page's references in trace order, by
+                  following the next-use links from its first reference
+    Inputs      : pages - page table from indexing (taken over)
+                  mask - its size - 1
+                  next - next-use index
+                  n - references in the trace
+    Outputs     : readahead table if successful, NULL otherwise
+
+***********************************************************************/
+
+static opt_ahead_t *opt_uses( opt_page_t *pages, uint32_t mask, uint32_t *next, uint32_t n )
+{
+  opt_ahead_t *a = (opt_ahead_t *)malloc( sizeof(opt_ahead_t) );
+  uint32_t at = 0, i, k, r;
+
+  if (( a == NULL ) ||
+      (( a->uses = (uint32_t *)malloc( sizeof(uint32_t) * ( n ? n : 1 ))) == NULL )) {
+    free( a );
+    free( pages );
+    return NULL;
+  }
+
+  a->pages = pages;
+  a->mask = mask;
+  for ( i = 0; i <= mask; i++ ) {
+    if ( pages[i].pid < 0 )
+      continue;
+    pages[i].at = at;
+    for ( k = at, r = pages[i].first; r != OPT_NEVER; r = next[r] )
+      a->uses[k++] = r;
+    at += pages[i].count;
+  }
+
+  return a;
+}
+
+
+/**********************************************************************
+
+    Function    : opt_upcoming
+    Description : find a page's next use, at or after a reference
+    Inputs      : o - opt state
+                  pid - process
+                  page - page number
+                  now - reference being run
+    Outputs     : its next use, or OPT_NEVER if none
+
+***********************************************************************/
+
+static uint32_t opt_upcoming( opt_t *o, int pid, vpn_t page, uint32_t now )
+{
+  opt_ahead_t *a = o->ahead;
+  uint32_t h = opt_slot( a->pages, a->mask, pid, page ), lo, hi, mid;
+
+  if ( a->pages[h].pid < 0 )
+    return OPT_NEVER;
+
+  lo = a->pages[h].at;
+  hi = lo + a->pages[h].count;
+  while ( lo < hi ) {
+    mid = lo + ( hi - lo ) / 2;
+    if ( a->uses[mid] < now )
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return ( lo < a->pages[h].at + a->pages[h].count ) ? a->uses[lo] : OPT_NEVER;
+}
+
+
+/**********************************************************************
+
+    Function    : opt_index
+    Description : read the trace once and link each reference to the
+                  next reference to the same page
+    Inputs      : tr - input trace, at its first reference
+                  ahead - if not NULL, gets the readahead table
+    Outputs     : next-use index if successful, NULL otherwise
+
+***********************************************************************/
+
+static uint32_t *opt_index( trace_t *tr, opt_ahead_t **ahead )
+{
+  opt_page_t *pages;
+  uint32_t mask = OPT_MIN_PAGES - 1, distinct = 0, n = 0, cap, i, h;
+  uint32_t *next, *more;
+  vaddr_t vaddr;
+  int pid, op, ret = 0, err = 0;
+
+  /* trace_open has checked the count against the file; it is only a
+     first guess at the size, the table still grows as needed */
+  cap = ( tr->count && ( tr->count < OPT_NEVER )) ? (uint32_t)tr->count : OPT_MIN_PAGES;
+  next = (uint32_t *)malloc( sizeof(uint32_t) * cap );
+  pages = (opt_page_t *)malloc( sizeof(opt_page_t) * ( mask + 1 ));
+  if (( next == NULL ) || ( pages == NULL ))
+    err = -1;
+  for ( i = 0; !err && ( i <= mask ); i++ )
+    pages[i].pid = -1;
+
+  while ( !err && (( ret = trace_next( tr, &pid, &vaddr, &op )) > 0 )) {
+    if ( n == OPT_NEVER - 1 ) {
+      fprintf( stderr, "opt: trace too long\n" );
+      err = -1;
+      break;
+    }
+    if ( n == cap ) {
+      cap = ( cap > OPT_NEVER / 2 ) ? OPT_NEVER - 1 : cap * 2;
+      if (( more = (uint32_t *)realloc( next, sizeof(uint32_t) * cap )) == NULL ) {
+	err = -1;
+	break;
+      }
+      next = more;
+    }
+
+    /* keep the table at most half full */
+    if (( 2 * ( distinct + 1 ) > mask + 1 ) && opt_grow( &pages, &mask )) {
+      err = -1;
+      break;
+    }
+
+    h = opt_slot( pages, mask, pid, vaddr >> page_shift );
+    if ( pages[h].pid < 0 ) {
+      pages[h].pid = pid;
+      pages[h].page = vaddr >> page_shift;
+      pages[h].first = n;
+      pages[h].count = 0;
+      distinct++;
+    }
+    else
+      next[pages[h].last] = n;
+
+    pages[h].last = n;
+    pages[h].count++;
+    next[n++] = OPT_NEVER;
+  }
+  if ( ret < 0 )
+    err = -1;
+
+  if ( err || ( ahead == NULL ))
+    free( pages );
+  else if (( *ahead = opt_uses( pages, mask, next, n )) == NULL )
+    err = -1;
+
+  if ( err ) {
+    free( next );
+    return NULL;
+  }
+  return next;
+}
+
+
+/**********************************************************************
+
+    Function    : opt_swap
+    Description : swap two heap positions
+    Inputs      : o - opt state
+                  i, j - heap positions
+    Outputs     : none
+
+***********************************************************************/
+
+static inline void opt_swap( opt_t *o, int i, int j )
+{
+  int f = o->heap[i];
+
+  o->heap[i] = o->heap[j];
+  o->heap[j] = f;
+  o->pos[o->heap[i]] = i;
+  o->pos[o->heap[j]] = j;
+}
+
+
+/**********************************************************************
+
+    Function    : opt_sift
+    Description : restore the heap after a frame's next use changed
+    Inputs      : o - opt state
+                  i - heap position of the frame
+    Outputs     : none
+
+***********************************************************************/
+
+static void opt_sift( opt_t *o, int i )
+{
+  int c;
+
+  /* up, while farther than the parent */
+  while (( i > 0 ) && ( o->key[o->heap[i]] > o->key[o->heap[( i - 1 ) / 2]] )) {
+    opt_swap( o, i, ( i - 1 ) / 2 );
+    i = ( i - 1 ) / 2;
+  }
+
+  /* down, while a child is farther */
+  while (( c = 2 * i + 1 ) < o->size ) {
+    if (( c + 1 < o->size ) && ( o->key[o->heap[c + 1]] > o->key[o->heap[c]] ))
+      c++;
+    if ( o->key[o->heap[c]] <= o->key[o->heap[i]] )
+      break;
+    opt_swap( o, i, c );
+    i = c;
+  }
+}
+
+
+/**********************************************************************
+
+    Function    : opt_set
+    Description : set the next use of the page in a frame
+    Inputs      : o - opt state
+                  frame - frame number
+                  key - next use
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+static int opt_set( opt_t *o, int frame, uint32_t key )
+{
+  int *heap, room;
+
+  o->key[frame] = key;
+
+  if ( o->pos[frame] < 0 ) {
+    /* a process's heap grows with the frames it holds */
+    if ( o->size == o->room ) {
+      room = ( 2 * o->room < sim->frames ) ? 2 * o->room : sim->frames;
+      if (( heap = (int *)realloc( o->heap, sizeof(int) * room )) == NULL )
+	return -1;
+      o->heap = heap;
+      o->room = room;
+    }
+    o->heap[o->size] = frame;
+    o->pos[frame] = o->size++;
+  }
+
+  opt_sift( o, o->pos[frame] );
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : init_opt
+    Description : build the next-use index and an empty heap
+    Inputs      : tr - input trace, rewound to its first reference
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int init_opt( trace_t *tr )
+{
+  opt_t *model = (opt_t *)sim->repl;
+  opt_t *o = (opt_t *)calloc( 1, sizeof(opt_t) );
+  int i;
+
+  if (( sim->repl = o ) == NULL )
+    return -1;
+
+  /* under local replacement, each process's state uses the index built
+     when the machine was made, and the frame arrays too (a frame is in
+     one heap at most); its own heap starts small */
+  if ( model ) {
+    o->next = model->next;
+    o->ahead = model->ahead;
+    o->shared = 1;
+    o->key = model->key;
+    o->pid = model->pid;
+    o->pos = model->pos;
+    o->frames_shared = 1;
+    o->room = ( sim->frames > QDIR_MIN ) ? QDIR_MIN : sim->frames;
+    o->heap = (int *)malloc( sizeof(int) * o->room );
+    return ( o->heap == NULL ) ? -1 : 0;
+  }
+
+  o->room = sim->frames;
+  o->key = (uint32_t *)malloc( sizeof(uint32_t) * sim->frames );
+  o->pid = (int *)calloc( sim->frames, sizeof(int) );
+  o->heap = (int *)malloc( sizeof(int) * sim->frames );
+  o->pos = (int *)malloc( sizeof(int) * sim->frames );
+  if (( o->key == NULL ) || ( o->pid == NULL ) || ( o->heap == NULL ) || ( o->pos == NULL ))
+    return -1;
+
+  for ( i = 0; i < sim->frames; i++ )
+    o->pos[i] = -1;
+
+  /* in-memory traces are only ever replayed whole: index them once */
+  if ( tr->mem ) {
+    pthread_mutex_lock( &opt_lock );
+    if ( opt_shared_start != tr->start ) {
+      free( opt_shared_next );
+      opt_free_ahead( opt_shared_ahead );
+      opt_shared_ahead = NULL;
+      opt_shared_start = tr->start;
+      opt_shared_next = opt_index( tr, readahead_max ? &opt_shared_ahead : NULL );
+    }
+    o->next = opt_shared_next;
+    o->ahead = opt_shared_ahead;
+    o->shared = 1;
+    pthread_mutex_unlock( &opt_lock );
+  }
+  else
+    o->next = opt_index( tr, readahead_max ? &o->ahead : NULL );
+
+  if ( readahead_max && ( o->ahead == NULL ))
+    return -1;
+  return ( o->next == NULL ) ? -1 : 0;
+}
+
+
+/**********************************************************************
+
+    Function    : exit_opt
+    Description : free the heap and any index of our own
+    Inputs      : none
+    Outputs     : none
+
+***********************************************************************/
+
+void exit_opt( void )
+{
+  opt_t *o = (opt_t *)sim->repl;
+
+  if ( !o->shared ) {
+    free( o->next );
+    opt_free_ahead( o->ahead );
+  }
+  if ( !o->frames_shared ) {
+    free( o->key );
+    free( o->pid );
+    free( o->pos );
+  }
+  free( o->heap );
+  free( o );
+}
+
+
+/**********************************************************************
+
+    Function    : replace_opt
+    Description : choose the frame whose page is used farthest ahead
+    Inputs      : pid - process id of victim frame 
+                  victim - frame assignment 
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int replace_opt( int *pid, frame_t **victim )
+{
+  opt_t *o = (opt_t *)sim->repl;
+  int frame;
+
+  if ( o->size == 0 )
+    return -1;
+
+  // The frame stays in the heap: the page faulting in re-keys it
+  frame = o->heap[0];
+  *victim = &(sim->physical_mem[frame]);
+  *pid = o->pid[frame];
+
+  EVENT( LOG_FAULTS, EV_VICTIM, *pid, sim->physical_mem[frame].page, frame, 0 );
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : update_opt
+    Description : a page was loaded into a frame: key it on its next use
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int update_opt( int pid, frame_t *f )
+{
+  opt_t *o = (opt_t *)sim->repl;
+  uint32_t now = sim->total_accesses - 1;
+
+  o->pid[f->number] = pid;
+
+  /* the first page loaded for a reference is the one referenced.  A
+     page read ahead is keyed on its next use from the page table; any
+     others (the rest of a promoted huge page) were not referenced, and
+     their next use is not in the index -- they go first */
+  if ( !sim->prefetching && (( o->now != now ) || ( o->size == 0 ))) {
+    o->now = now;
+    return opt_set( o, f->number, o->next[now] );
+  }
+  else if ( sim->prefetching && o->ahead )
+    return opt_set( o, f->number, opt_upcoming( o, pid, f->page, now ));
+
+  return opt_set( o, f->number, OPT_NEVER );
+}
+
+
+/**********************************************************************
+
+    Function    : ref_opt
+    Description : a resident page was referenced: key it on its next use
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int ref_opt( int pid, frame_t *f )
+{
+  opt_t *o = (opt_t *)sim->repl;
+  uint32_t now = sim->total_accesses - 1;
+
+  o->now = now;
+  return opt_set( o, f->number, o->next[now] );
+}
+
+
+/**********************************************************************
+
+    Function    : release_opt
+    Description : the page in frame f was swapped out with its process:
+                  take the frame out of the heap
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int release_opt( int pid, frame_t *f )
+{
+  opt_t *o = (opt_t *)sim->repl;
+  int i = o->pos[f->number];
+
+  if ( i < 0 )
+    return 0;
+
+  /* the last frame of the heap takes its place */
+  opt_swap( o, i, --o->size );
+  o->pos[f->number] = -1;
+  if ( i < o->size )
+    opt_sift( o, i );
+
+  return 0;
+}
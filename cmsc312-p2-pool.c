@@ -0,0 +1,158 @@
+/**********************************************************************
+
+   File          : cmsc312-p2-pool.c
+
+   Description   : This is a fixed-capacity node pool for replacement
+                   bookkeeping.  All nodes come from one contiguous slab
+                   sized at init and are recycled through a free list,
+                   so the fault path never calls malloc or free
+                   (see .h for applications)
+
+***********************************************************************/
+/**********************************************************************
+Copyright (c) 2016 The Pennsylvania State University
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of The Pennsylvania State University nor the names of its contributors may be used to endorse or promote products derived from this softwiare without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* Include Files */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <assert.h>
+
+/* Project Include Files */
+#include "cmsc312-p2.h"
+
+/* Definitions */
+
+/* a free node holds the link to the next free node */
+typedef struct pool_free {
+  struct pool_free *next;
+} pool_free_t;
+
+
+/**********************************************************************
+
+    Function    : pool_create
+    Description : carve a slab into capacity nodes of the given size
+    Inputs      : size - bytes per node
+                  capacity - number of nodes
+    Outputs     : pool if successful, NULL otherwise
+
+***********************************************************************/
+
+pool_t *pool_create( size_t size, int capacity )
+{
+  pool_t *pool = (pool_t *)malloc( sizeof(pool_t) );
+
+  if ( pool == NULL )
+    return NULL;
+
+  /* keep every node pointer-aligned and big enough for the free link */
+  if ( size < sizeof(pool_free_t) )
+    size = sizeof(pool_free_t);
+  size = ( size + sizeof(void *) - 1 ) & ~( sizeof(void *) - 1 );
+
+  pool->size = size;
+  pool->capacity = capacity;
+  pool->used = 0;
+  pool->free = NULL;
+  pool->base = (unsigned char *)malloc( size * capacity );
+
+  if ( pool->base == NULL ) {
+    free( pool );
+    return NULL;
+  }
+
+  return pool;
+}
+
+
+/**********************************************************************
+
+    Function    : pool_alloc
+    Description : take a node: recycled nodes first, then fresh slab
+    Inputs      : pool - node pool
+    Outputs     : node, or NULL if the pool is exhausted
+
+***********************************************************************/
+
+void *pool_alloc( pool_t *pool )
+{
+  pool_free_t *node = (pool_free_t *)pool->free;
+
+  if ( node ) {
+    pool->free = node->next;
+    return node;
+  }
+
+  if ( pool->used == pool->capacity )
+    return NULL;
+
+  return pool->base + pool->size * pool->used++;
+}
+
+
+/**********************************************************************
+
+    Function    : pool_free
+    Description : return a node to the pool
+    Inputs      : pool - node pool
+                  p - node from pool_alloc
+    Outputs     : none
+
+***********************************************************************/
+
+void pool_free( pool_t *pool, void *p )
+{
+  pool_free_t *node = (pool_free_t *)p;
+
+  assert(( (unsigned char *)p >= pool->base ) &&
+	 ( (unsigned char *)p < pool->base + pool->size * pool->capacity ));
+
+  node->next = (pool_free_t *)pool->free;
+  pool->free = node;
+}
+
+
+/**********************************************************************
+
+    Function    : pool_destroy
+    Description : release the slab and the pool
+    Inputs      : pool - node pool
+    Outputs     : none
+
+***********************************************************************/
+
+void pool_destroy( pool_t *pool )
+{
+  if ( pool == NULL )
+    return;
+
+  free( pool->base );
+  free( pool );
+}
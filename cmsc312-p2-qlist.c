@@ -0,0 +1,538 @@
+/**********************************************************************
+
+   File          : cmsc312-p2-qlist.c
+
+   Description   : This is the list engine behind the adaptive
+                   replacement algorithms (ARC, CAR, 2Q, LIRS).  Index
+                   lists link frame numbers or directory entries through
+                   arrays; the directory hashes (pid, page) to entries
+                   for pages those algorithms remember beyond their
+                   frames, such as the ghosts of recently evicted pages.
+                   Every operation is O(1)
+                   (see .h for applications)
+
+***********************************************************************/
+/**********************************************************************
+Copyright (c) 2016 The Pennsylvania State University
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of The Pennsylvania State University nor the names of its contributors may be used to endorse or promote products derived from this softwiare without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* Include Files */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <assert.h>
+
+/* Project Include Files */
+#include "cmsc312-p2.h"
+
+/* Definitions */
+
+
+/**********************************************************************
+
+    Function    : qlist_init
+    Description : create an empty list of the integers 0..n-1
+    Inputs      : q - list
+                  n - number of integers
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int qlist_init( qlist_t *q, int n )
+{
+  int i;
+
+  q->prev = (int *)malloc( sizeof(int) * n );
+  q->next = (int *)malloc( sizeof(int) * n );
+  q->head = q->tail = QLIST_NONE;
+  q->len = 0;
+
+  if (( q->prev == NULL ) || ( q->next == NULL ))
+    return -1;
+
+  for ( i = 0; i < n; i++ )
+    q->prev[i] = QLIST_OFF;
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : qlist_share
+    Description : start an empty list over another list's links, for
+                  integers that are on one of the lists at most
+    Inputs      : q - list
+                  from - list whose links it shares (and frees)
+    Outputs     : none
+
+***********************************************************************/
+
+void qlist_share( qlist_t *q, qlist_t *from )
+{
+  q->prev = from->prev;
+  q->next = from->next;
+  q->head = q->tail = QLIST_NONE;
+  q->len = 0;
+}
+
+
+/**********************************************************************
+
+    Function    : qlist_grow
+    Description : make room for more integers on a list
+    Inputs      : q - list
+                  n - integers it has room for now
+                  more - integers it needs room for
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int qlist_grow( qlist_t *q, int n, int more )
+{
+  int *prev, *next, i;
+
+  if (( prev = (int *)realloc( q->prev, sizeof(int) * more )) != NULL )
+    q->prev = prev;
+  if (( next = (int *)realloc( q->next, sizeof(int) * more )) != NULL )
+    q->next = next;
+  if (( prev == NULL ) || ( next == NULL ))
+    return -1;
+
+  for ( i = n; i < more; i++ )
+    q->prev[i] = QLIST_OFF;
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : qlist_free
+    Description : release a list's links
+    Inputs      : q - list
+    Outputs     : none
+
+***********************************************************************/
+
+void qlist_free( qlist_t *q )
+{
+  free( q->prev );
+  free( q->next );
+}
+
+
+/**********************************************************************
+
+    Function    : qlist_push
+    Description : put an integer at the head (most recent end)
+    Inputs      : q - list
+                  i - integer, not on the list
+    Outputs     : none
+
+***********************************************************************/
+
+void qlist_push( qlist_t *q, int i )
+{
+  assert( !qlist_on( q, i ));
+
+  q->prev[i] = QLIST_NONE;
+  q->next[i] = q->head;
+  if ( q->head != QLIST_NONE )
+    q->prev[q->head] = i;
+  else
+    q->tail = i;
+  q->head = i;
+  q->len++;
+}
+
+
+/**********************************************************************
+
+    Function    : qlist_append
+    Description : put an integer at the tail (least recent end)
+    Inputs      : q - list
+                  i - integer, not on the list
+    Outputs     : none
+
+***********************************************************************/
+
+void qlist_append( qlist_t *q, int i )
+{
+  assert( !qlist_on( q, i ));
+
+  q->next[i] = QLIST_NONE;
+  q->prev[i] = q->tail;
+  if ( q->tail != QLIST_NONE )
+    q->next[q->tail] = i;
+  else
+    q->head = i;
+  q->tail = i;
+  q->len++;
+}
+
+
+/**********************************************************************
+
+    Function    : qlist_insert
+    Description : put an integer right after another, or at the head
+    Inputs      : q - list
+                  i - integer, not on the list
+                  after - integer on the list, or QLIST_NONE for the head
+    Outputs     : none
+
+***********************************************************************/
+
+void qlist_insert( qlist_t *q, int i, int after )
+{
+  assert( !qlist_on( q, i ));
+
+  if ( after == QLIST_NONE ) {
+    qlist_push( q, i );
+    return;
+  }
+  if ( after == q->tail ) {
+    qlist_append( q, i );
+    return;
+  }
+
+  q->prev[i] = after;
+  q->next[i] = q->next[after];
+  q->prev[q->next[after]] = i;
+  q->next[after] = i;
+  q->len++;
+}
+
+
+/**********************************************************************
+
+    Function    : qlist_remove
+    Description : take an integer off the list
+    Inputs      : q - list
+                  i - integer on the list
+    Outputs     : none
+
+***********************************************************************/
+
+void qlist_remove( qlist_t *q, int i )
+{
+  assert( qlist_on( q, i ));
+
+  if ( q->prev[i] != QLIST_NONE )
+    q->next[q->prev[i]] = q->next[i];
+  else
+    q->head = q->next[i];
+
+  if ( q->next[i] != QLIST_NONE )
+    q->prev[q->next[i]] = q->prev[i];
+  else
+    q->tail = q->prev[i];
+
+  q->prev[i] = QLIST_OFF;
+  q->len--;
+}
+
+
+/**********************************************************************
+
+    Function    : qdir_init
+    Description : create an empty directory of n entries
+    Inputs      : d - directory
+                  n - number of entries
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int qdir_init( qdir_t *d, int n )
+{
+  unsigned int size;
+  int i;
+
+  for ( size = 1; size < (unsigned int)n; size <<= 1 );
+  d->mask = size - 1;
+
+  d->page = (vpn_t *)malloc( sizeof(vpn_t) * n );
+  d->pid = (int *)malloc( sizeof(int) * n );
+  d->chain = (int *)malloc( sizeof(int) * n );
+  d->bucket = (int *)malloc( sizeof(int) * size );
+  d->free = (int *)malloc( sizeof(int) * n );
+  d->n = n;
+  d->nfree = n;
+
+  if (( d->page == NULL ) || ( d->pid == NULL ) || ( d->chain == NULL ) ||
+      ( d->bucket == NULL ) || ( d->free == NULL ))
+    return -1;
+
+  for ( i = 0; i < (int)size; i++ )
+    d->bucket[i] = QLIST_NONE;
+  for ( i = 0; i < n; i++ )
+    d->free[i] = n - 1 - i;     /* hand out low entries first */
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : qdir_free
+    Description : release a directory
+    Inputs      : d - directory
+    Outputs     : none
+
+***********************************************************************/
+
+void qdir_free( qdir_t *d )
+{
+  free( d->page );
+  free( d->pid );
+  free( d->chain );
+  free( d->bucket );
+  free( d->free );
+}
+
+
+/**********************************************************************
+
+    Function    : qdir_hash
+    Description : chain of a page
+    Inputs      : d - directory
+                  pid - process
+                  page - page number
+    Outputs     : bucket index
+
+***********************************************************************/
+
+static inline unsigned int qdir_hash( qdir_t *d, int pid, vpn_t page )
+{
+  uint64_t h = ( page ^ ((uint64_t)pid << 48 )) * 0x9E3779B97F4A7C15ULL;
+
+  return ( h >> 32 ) & d->mask;
+}
+
+
+/**********************************************************************
+
+    Function    : qdir_find
+    Description : look up a page
+    Inputs      : d - directory
+                  pid - process
+                  page - page number
+    Outputs     : entry, or QLIST_NONE if the page has none
+
+***********************************************************************/
+
+int qdir_find( qdir_t *d, int pid, vpn_t page )
+{
+  int i;
+
+  for ( i = d->bucket[qdir_hash( d, pid, page )]; i != QLIST_NONE; i = d->chain[i] ) {
+    if (( d->page[i] == page ) && ( d->pid[i] == pid ))
+      break;
+  }
+
+  return i;
+}
+
+
+/**********************************************************************
+
+    Function    : qdir_add
+    Description : give a page an entry
+    Inputs      : d - directory
+                  pid - process
+                  page - page number, not in the directory
+    Outputs     : entry, or QLIST_NONE if the directory is full
+
+***********************************************************************/
+
+int qdir_add( qdir_t *d, int pid, vpn_t page )
+{
+  unsigned int h = qdir_hash( d, pid, page );
+  int i;
+
+  if ( d->nfree == 0 )
+    return QLIST_NONE;
+
+  i = d->free[--d->nfree];
+  d->page[i] = page;
+  d->pid[i] = pid;
+  d->chain[i] = d->bucket[h];
+  d->bucket[h] = i;
+
+  return i;
+}
+
+
+/**********************************************************************
+
+    Function    : qdir_grow
+    Description : double a full directory, keeping its entries' numbers
+    Inputs      : d - directory, with no free entry
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int qdir_grow( qdir_t *d )
+{
+  int old = d->n, n = 2 * d->n;
+  unsigned int size = 2 * ( d->mask + 1 ), h;
+  vpn_t *page;
+  int *pid, *chain, *bucket, *free_list;
+  int i;
+
+  assert( d->nfree == 0 );
+
+  if (( page = (vpn_t *)realloc( d->page, sizeof(vpn_t) * n )) != NULL )
+    d->page = page;
+  if (( pid = (int *)realloc( d->pid, sizeof(int) * n )) != NULL )
+    d->pid = pid;
+  if (( chain = (int *)realloc( d->chain, sizeof(int) * n )) != NULL )
+    d->chain = chain;
+  if (( free_list = (int *)realloc( d->free, sizeof(int) * n )) != NULL )
+    d->free = free_list;
+  if (( page == NULL ) || ( pid == NULL ) || ( chain == NULL ) || ( free_list == NULL ) ||
+      (( bucket = (int *)malloc( sizeof(int) * size )) == NULL ))
+    return -1;
+
+  /* every old entry is in use: rehash them all into the wider table */
+  free( d->bucket );
+  d->bucket = bucket;
+  d->mask = size - 1;
+  for ( i = 0; i < (int)size; i++ )
+    d->bucket[i] = QLIST_NONE;
+  for ( i = 0; i < old; i++ ) {
+    h = qdir_hash( d, d->pid[i], d->page[i] );
+    d->chain[i] = d->bucket[h];
+    d->bucket[h] = i;
+  }
+
+  for ( i = 0; i < n - old; i++ )
+    d->free[i] = n - 1 - i;
+  d->nfree = n - old;
+  d->n = n;
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : qdir_room
+    Description : make sure a directory has a free entry, growing it and
+                  the lists of its entries when it is full
+    Inputs      : d - directory
+                  lists - lists of its entries
+                  n - number of lists
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int qdir_room( qdir_t *d, qlist_t **lists, int n )
+{
+  int old = d->n, i;
+
+  if ( d->nfree )
+    return 0;
+
+  if ( qdir_grow( d ))
+    return -1;
+  for ( i = 0; i < n; i++ ) {
+    if ( qlist_grow( lists[i], old, d->n ))
+      return -1;
+  }
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : qdir_del
+    Description : release a page's entry
+    Inputs      : d - directory
+                  i - entry
+    Outputs     : none
+
+***********************************************************************/
+
+void qdir_del( qdir_t *d, int i )
+{
+  int *link;
+
+  for ( link = &d->bucket[qdir_hash( d, d->pid[i], d->page[i] )]; *link != i;
+	link = &d->chain[*link] )
+    assert( *link != QLIST_NONE );
+
+  *link = d->chain[i];
+  d->free[d->nfree++] = i;
+}
+
+
+/**********************************************************************
+
+    Function    : qdir_ghost
+    Description : remember an evicted page at the head of a ghost list
+    Inputs      : d - directory
+                  q - ghost list of directory entries
+                  pid - process
+                  page - page number
+    Outputs     : entry, or QLIST_NONE if the directory is full
+
+***********************************************************************/
+
+int qdir_ghost( qdir_t *d, qlist_t *q, int pid, vpn_t page )
+{
+  int i = qdir_add( d, pid, page );
+
+  if ( i != QLIST_NONE )
+    qlist_push( q, i );
+
+  return i;
+}
+
+
+/**********************************************************************
+
+    Function    : qdir_drop
+    Description : forget the oldest page of a ghost list
+    Inputs      : d - directory
+                  q - ghost list of directory entries
+    Outputs     : none
+
+***********************************************************************/
+
+void qdir_drop( qdir_t *d, qlist_t *q )
+{
+  int i = q->tail;
+
+  if ( i == QLIST_NONE )
+    return;
+
+  qlist_remove( q, i );
+  qdir_del( d, i );
+}
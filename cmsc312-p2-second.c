@@ -38,6 +38,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <unistd.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <sys/types.h>
@@ -51,35 +52,74 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 /* Definitions */
 
-/* second chance list */
-
-typedef struct second_entry {  
-  int pid;
-  ptentry_t *ptentry;
-  struct second_entry *next;
-  struct second_entry *prev;
-} second_entry_t;
+/* CLOCK over the frame array: the hand sweeps frame numbers in order and
+   the reference bits sit in a bitmap beside it, so a sweep clears and
+   tests 64 frames per word */
 
 typedef struct second {
-  second_entry_t *first;
+  int *pid;                   /* process owning the page in each frame */
+  uint64_t *ref;              /* reference bit per frame */
+  uint64_t *own;              /* frames holding a page tracked here (all of
+                                 them, unless replacement is local) */
+  int words;
+  int owned;
+  int hand;                   /* next frame to examine */
+  int shared;                 /* pid and ref are the machine's first clock's */
 } second_t;
 
-second_t *page_list;
+/* each simulated machine keeps its own clock as sim->repl */
 
 /**********************************************************************
 
     Function    : init_second
-    Description : initialize second-chance list
-    Inputs      : fp - input file of data
+    Description : initialize the clock and its reference bitmap (under
+                  local replacement, a process's clock keeps only the
+                  bitmap of the frames it owns, sharing the rest with
+                  the machine's: a frame is owned by one clock at most)
+    Inputs      : tr - input trace
     Outputs     : 0 if successful, -1 otherwise
 
 ***********************************************************************/
 
-int init_second( FILE *fp )
+int init_second( trace_t *tr )
 {
-  page_list = (second_t *)malloc(sizeof(second_t));
-  page_list->first = NULL;
-  return 0;
+  second_t *model = (second_t *)sim->repl;
+  second_t *c = (second_t *)malloc( sizeof(second_t) );
+
+  if (( sim->repl = c ) == NULL )
+    return -1;
+
+  c->words = BITMAP_WORDS( sim->frames );
+  c->shared = ( model != NULL );
+  c->pid = model ? model->pid : (int *)calloc( sim->frames, sizeof(int) );
+  c->ref = model ? model->ref : (uint64_t *)calloc( c->words, sizeof(uint64_t) );
+  c->own = (uint64_t *)calloc( c->words, sizeof(uint64_t) );
+  c->owned = 0;
+  c->hand = 0;
+
+  return (( c->pid == NULL ) || ( c->ref == NULL ) || ( c->own == NULL )) ? -1 : 0;
+}
+
+
+/**********************************************************************
+
+    Function    : exit_second
+    Description : free the clock
+    Inputs      : none
+    Outputs     : none
+
+***********************************************************************/
+
+void exit_second( void )
+{
+  second_t *c = (second_t *)sim->repl;
+
+  if ( !c->shared ) {
+    free( c->pid );
+    free( c->ref );
+  }
+  free( c->own );
+  free( c );
 }
 
 
@@ -87,6 +127,8 @@ int init_second( FILE *fp )
 
     Function    : replace_second
     Description : choose victim based on second chance algorithm (first with ref == 0)
+                  starting at the clock hand; referenced frames passed
+                  over lose their bit (their second chance)
     Inputs      : pid - process id of victim frame 
                   victim - frame assigned from fifo -- to be replaced
     Outputs     : 0 if successful, -1 otherwise
@@ -96,33 +138,40 @@ int init_second( FILE *fp )
 int replace_second( int *pid, frame_t **victim )
 {
   /* Task #3 */
-  second_entry_t *current = page_list->first;
-  while(current->next){
-    if(current->ptentry->bits & REFBIT){ // If ref is 1, set it to 0 (i.e. give this entry a second chance)
-      current->ptentry->bits &= DIRTYBIT | VALIDBIT;
-    }
-    else { // If ref is 0, use this entry
+  second_t *c = (second_t *)sim->repl;
+  int last = c->words - 1;
+  uint64_t mask, zeros;
+  int w, frame;
+
+  if ( c->owned == 0 )
+    return -1;
+
+  while ( TRUE ) {
+    w = c->hand >> 6;
+    mask = ( ~0ULL << ( c->hand & 63 )) & c->own[w];
+
+    zeros = ~c->ref[w] & mask;
+    if ( zeros ) {
+      frame = ( w << 6 ) + __builtin_ctzll( zeros );
+      /* frames between the hand and the victim used their second chance */
+      c->ref[w] &= ~( mask & (( 1ULL << ( frame & 63 )) - 1 ));
       break;
     }
-    current = current->next;
-  }
-  
-  // Remove current from the linked list
-  if(current->next){
-    current->next->prev = current->prev;
-  }
-  if(current->prev){
-    current->prev->next = current->next;
-  } else{
-    page_list->first = current->next;
+
+    /* every frame left in this word was referenced: clear and move on */
+    c->ref[w] &= ~mask;
+    c->hand = ( w == last ) ? 0 : ( w + 1 ) << 6;
   }
 
-  // Set victim to the frame given by the frame value of current's ptentry
-  *victim = &(physical_mem[current->ptentry->frame]);
-  *pid = current->pid;
-  free(current);
+  c->hand = ( frame + 1 == sim->frames ) ? 0 : frame + 1;
 
-  printf("replace_second: Selected frame %i for replacement\n", current->ptentry->frame);
+  // Set victim to the frame under the hand
+  *victim = &(sim->physical_mem[frame]);
+  *pid = c->pid[frame];
+  BITMAP_CLEAR( c->own, frame );
+  c->owned--;
+
+  EVENT( LOG_FAULTS, EV_VICTIM, *pid, sim->physical_mem[frame].page, frame, 0 );
   return 0;
 }
 
@@ -130,7 +179,8 @@ int replace_second( int *pid, frame_t **victim )
 /**********************************************************************
 
     Function    : update_second
-    Description : update second chance on allocation 
+    Description : update second chance on allocation -- the frame's new
+                  page starts referenced, just behind the hand
     Inputs      : pid - process id
                   f - frame
     Outputs     : 0 if successful, -1 otherwise
@@ -140,27 +190,57 @@ int replace_second( int *pid, frame_t **victim )
 int update_second( int pid, frame_t *f )
 {
   /* Task #3 */
-  // Make new list entry
-  second_entry_t *list_entry = ( second_entry_t *)malloc(sizeof(second_entry_t));
-  list_entry->pid = pid;
-  list_entry->ptentry = &(processes[pid].pagetable[f->page]);
-  list_entry->next = NULL;
-  list_entry->prev = NULL;
-
-  // If the page list has items, put this one at the end
-  if(page_list->first){
-    second_entry_t *last = page_list->first;
-    while(last->next){
-      last = last->next;
-    }
-    last->next = list_entry;
-    list_entry->prev = last;
-  }
-  else{ // Else put this one as first
-    page_list->first = list_entry;
+  second_t *c = (second_t *)sim->repl;
+
+  c->pid[f->number] = pid;
+  BITMAP_SET( c->ref, f->number );
+  if ( !BITMAP_TEST( c->own, f->number )) {
+    BITMAP_SET( c->own, f->number );
+    c->owned++;
   }
 
   return 0;  
 }
 
 
+/**********************************************************************
+
+    Function    : ref_second
+    Description : the page in frame f was referenced -- set its bit
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int ref_second( int pid, frame_t *f )
+{
+  second_t *c = (second_t *)sim->repl;
+
+  BITMAP_SET( c->ref, f->number );
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : release_second
+    Description : the page in frame f was swapped out with its process:
+                  clear its bit
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int release_second( int pid, frame_t *f )
+{
+  second_t *c = (second_t *)sim->repl;
+
+  BITMAP_CLEAR( c->ref, f->number );
+  if ( BITMAP_TEST( c->own, f->number )) {
+    BITMAP_CLEAR( c->own, f->number );
+    c->owned--;
+  }
+  return 0;
+}
@@ -0,0 +1,410 @@
+/**********************************************************************
+
+   File          : cmsc312-p2-stack.c
+
+   Description   : This is the miss-ratio curve: LRU is a stack
+                   algorithm, so a reference faults with F frames
+                   exactly when its LRU stack distance exceeds F, and one
+                   pass that histograms stack distances gives the faults
+                   for every frame count (Mattson et al.).  A page's
+                   distance is the number of distinct pages used since
+                   its last use: each page keeps one mark at the time of
+                   its last use in a Fenwick tree over time, so the
+                   distance is a prefix sum, O(log n).  Times are
+                   renumbered when the tree fills, so it stays sized by
+                   the pages in use rather than the trace length
+                   (see .h for applications)
+
+***********************************************************************/
+/**********************************************************************
+Copyright (c) 2016 The Pennsylvania State University
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of The Pennsylvania State University nor the names of its contributors may be used to endorse or promote products derived from this softwiare without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* Include Files */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <assert.h>
+
+/* Project Include Files */
+#include "cmsc312-p2.h"
+
+/* Definitions */
+#define STACK_MIN_TIMES  1024
+#define STACK_KNEES      3
+
+/* a page seen in the trace */
+typedef struct stack_page {
+  vpn_t page;
+  int pid;                      /* -1 for an empty hash slot */
+  uint32_t last;                /* time of last use */
+} stackdist_page_t;
+
+typedef struct stack {
+  stackdist_page_t *pages;          /* open addressing on (pid, page) */
+  uint32_t mask;
+  uint32_t distinct;
+  uint32_t *tree;               /* Fenwick tree over times 1..times */
+  uint32_t *owner;              /* page (hash slot) last used at each time */
+  uint32_t times;
+  uint32_t now;
+  uint64_t *hist;               /* references at each distance, 1..distinct */
+  uint32_t hist_len;
+  uint64_t cold;                /* first references */
+  uint64_t refs;
+} stackdist_t;
+
+
+/**********************************************************************
+
+    Function    : stack_hash
+    Description : hash slot of a page
+    Inputs      : st - stack state
+                  pid - process
+                  page - page number
+    Outputs     : first slot to probe
+
+***********************************************************************/
+
+static inline uint32_t stack_hash( stackdist_t *st, int pid, vpn_t page )
+{
+  uint64_t h = ( page ^ ((uint64_t)pid << 48 )) * 0x9E3779B97F4A7C15ULL;
+
+  return ( h >> 32 ) & st->mask;
+}
+
+
+/**********************************************************************
+
+    Function    : stack_tree_add
+    Description : add to the mark count at a time
+    Inputs      : st - stack state
+                  t - time (1-based)
+                  v - +1 or -1
+    Outputs     : none
+
+***********************************************************************/
+
+static void stack_tree_add( stackdist_t *st, uint32_t t, int v )
+{
+  for ( ; t <= st->times; t += t & -t )
+    st->tree[t] += v;
+}
+
+
+/**********************************************************************
+
+    Function    : stack_tree_sum
+    Description : count the marks at times 1..t
+    Inputs      : st - stack state
+                  t - time (1-based)
+    Outputs     : number of pages last used at or before t
+
+***********************************************************************/
+
+static uint32_t stack_tree_sum( stackdist_t *st, uint32_t t )
+{
+  uint32_t sum = 0;
+
+  for ( ; t > 0; t -= t & -t )
+    sum += st->tree[t];
+
+  return sum;
+}
+
+
+/**********************************************************************
+
+    Function    : stack_renumber
+    Description : give the pages times 1..distinct in last-use order, in
+                  a tree with room for as many again
+    Inputs      : st - stack state
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+static int stack_renumber( stackdist_t *st )
+{
+  uint32_t times = 2 * st->distinct;
+  uint32_t *tree, *owner;
+  uint32_t t, n = 0;
+
+  if ( times < STACK_MIN_TIMES )
+    times = STACK_MIN_TIMES;
+
+  tree = (uint32_t *)calloc( times + 1, sizeof(uint32_t) );
+  owner = (uint32_t *)malloc( sizeof(uint32_t) * ( times + 1 ));
+  if (( tree == NULL ) || ( owner == NULL )) {
+    free( tree );
+    free( owner );
+    return -1;
+  }
+
+  /* the live marks, oldest first, are the pages in LRU order */
+  for ( t = 1; t <= st->now; t++ ) {
+    if ( st->pages[st->owner[t]].last == t ) {
+      owner[++n] = st->owner[t];
+      st->pages[owner[n]].last = n;
+    }
+  }
+
+  /* a tree of all ones: each node counts the times it covers */
+  for ( t = 1; t <= n; t++ )
+    tree[t] = ( t & -t );
+  for ( t = n + 1; t <= times; t++ )
+    tree[t] = ( t - ( t & -t ) >= n ) ? 0 : n - ( t - ( t & -t ));
+
+  free( st->tree );
+  free( st->owner );
+  st->tree = tree;
+  st->owner = owner;
+  st->times = times;
+  st->now = n;
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : stack_grow
+    Description : double the page hash table and the histogram
+    Inputs      : st - stack state
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+static int stack_grow( stackdist_t *st )
+{
+  stackdist_page_t *old = st->pages;
+  uint32_t n = st->mask + 1, i, h;
+  uint64_t *hist;
+
+  if (( st->pages = (stackdist_page_t *)malloc( sizeof(stackdist_page_t) * n * 2 )) == NULL )
+    return -1;
+  st->mask = n * 2 - 1;
+  for ( i = 0; i < n * 2; i++ ) {
+    st->pages[i].pid = -1;
+    st->pages[i].last = 0;      /* a stale owner[] slot is never a live mark */
+  }
+
+  for ( i = 0; i < n; i++ ) {
+    if ( old[i].pid < 0 )
+      continue;
+    for ( h = stack_hash( st, old[i].pid, old[i].page ); st->pages[h].pid >= 0;
+	  h = ( h + 1 ) & st->mask );
+    st->pages[h] = old[i];
+    st->owner[old[i].last] = h;
+  }
+  free( old );
+
+  if (( hist = (uint64_t *)realloc( st->hist, sizeof(uint64_t) * ( n * 2 + 1 ))) == NULL )
+    return -1;
+  memset( hist + st->hist_len, 0, sizeof(uint64_t) * ( n * 2 + 1 - st->hist_len ));
+  st->hist = hist;
+  st->hist_len = n * 2 + 1;
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : stack_ref
+    Description : record one reference: its stack distance, and its mark
+                  moved to now
+    Inputs      : st - stack state
+                  pid - process
+                  page - page number
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+static int stack_ref( stackdist_t *st, int pid, vpn_t page )
+{
+  uint32_t h;
+
+  for ( h = stack_hash( st, pid, page ); st->pages[h].pid >= 0; h = ( h + 1 ) & st->mask ) {
+    if (( st->pages[h].page == page ) && ( st->pages[h].pid == pid ))
+      break;
+  }
+
+  if ( st->pages[h].pid < 0 ) {
+    /* keep the table at most half full */
+    if ( 2 * ( st->distinct + 1 ) > st->mask + 1 ) {
+      if ( stack_grow( st ))
+	return -1;
+      return stack_ref( st, pid, page );
+    }
+    st->pages[h].pid = pid;
+    st->pages[h].page = page;
+    st->pages[h].last = 0;
+    st->distinct++;
+    st->cold++;
+  }
+  else {
+    /* distinct pages used since: marks after the last use, plus itself */
+    st->hist[st->distinct - stack_tree_sum( st, st->pages[h].last ) + 1]++;
+    stack_tree_add( st, st->pages[h].last, -1 );
+    st->pages[h].last = 0;      /* not live if we renumber below */
+  }
+
+  if (( st->now == st->times ) && stack_renumber( st ))
+    return -1;
+
+  st->now++;
+  st->owner[st->now] = h;
+  st->pages[h].last = st->now;
+  stack_tree_add( st, st->now, 1 );
+  st->refs++;
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : stack_curve
+    Description : write LRU faults versus frame count for the trace, and
+                  the frame counts where the curve bends
+    Inputs      : tr - input trace, at its first reference
+                  out - output file
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int stack_curve( trace_t *tr, FILE *out )
+{
+  stackdist_t st;
+  uint64_t *faults;
+  uint64_t avoidable;
+  int pid, op, ret = 0, err = 0;
+  vaddr_t vaddr;
+  uint32_t f, i, k, knees[STACK_KNEES];
+  int64_t score, best;
+  double cover[] = { 0.5, 0.9, 0.99 };
+
+  memset( &st, 0, sizeof(st) );
+  st.mask = STACK_MIN_TIMES - 1;
+  st.pages = (stackdist_page_t *)malloc( sizeof(stackdist_page_t) * STACK_MIN_TIMES );
+  st.hist = (uint64_t *)calloc( STACK_MIN_TIMES + 1, sizeof(uint64_t) );
+  st.hist_len = STACK_MIN_TIMES + 1;
+  if (( st.pages == NULL ) || ( st.hist == NULL ) || stack_renumber( &st )) {
+    fprintf( stderr, "stack: out of memory\n" );
+    return -1;
+  }
+  for ( i = 0; i <= st.mask; i++ ) {
+    st.pages[i].pid = -1;
+    st.pages[i].last = 0;
+  }
+
+  while ( !err && (( ret = trace_next( tr, &pid, &vaddr, &op )) > 0 )) {
+    if (( pid < 0 ) || ( pid >= max_processes )) {
+      fprintf( stderr, "bad pid %d in trace\n", pid );
+      err = -1;
+    }
+    else if ( stack_ref( &st, pid, vaddr >> page_shift )) {
+      fprintf( stderr, "stack: out of memory\n" );
+      err = -1;
+    }
+  }
+  if ( ret < 0 )
+    err = -1;
+
+  /* faults[f]: with f frames, the first references and every reference
+     deeper than f */
+  faults = (uint64_t *)malloc( sizeof(uint64_t) * ( st.distinct + 2 ));
+  if ( !err && ( faults == NULL ))
+    err = -1;
+
+  if ( !err ) {
+    faults[st.distinct + 1] = st.cold;
+    faults[st.distinct] = st.cold;
+    for ( f = st.distinct; f > 0; f-- )
+      faults[f - 1] = faults[f] + st.hist[f];
+
+    fprintf( out, "++++++++++++++++++++ LRU Page-Fault Curve (stack distance) ++++++++++++++++++\n" );
+    fprintf( out, "references: %llu; pages: %u (first references fault with any frame count)\n",
+	     (unsigned long long)st.refs, st.distinct );
+    fprintf( out, "%10s %14s %10s\n", "frames", "faults", "fault%" );
+    /* the curve only steps down where some reference had that distance */
+    for ( f = 1; f <= st.distinct; f++ ) {
+      if (( f == 1 ) || st.hist[f] )
+	fprintf( out, "%10u %14llu %10.4f\n", f, (unsigned long long)faults[f],
+		 st.refs ? 100.0 * faults[f] / st.refs : 0.0 );
+    }
+
+    /* knees: where doubling memory stops paying -- the faults saved by
+       the last doubling less those saved by the next.  Knees are kept a
+       doubling apart */
+    for ( k = 0; k < STACK_KNEES; k++ ) {
+      knees[k] = 0;
+      best = 0;
+      for ( f = 2; f <= st.distinct; f++ ) {
+	if ( st.hist[f] == 0 )
+	  continue;
+	for ( i = 0; ( i < k ) && (( f * 2 <= knees[i] ) || ( f >= knees[i] * 2 )); i++ );
+	if ( i < k )
+	  continue;
+	score = (int64_t)( faults[f / 2] - faults[f] ) -
+	  (int64_t)( faults[f] - faults[( 2 * f > st.distinct ) ? st.distinct : 2 * f] );
+	if ( score > best ) {
+	  best = score;
+	  knees[k] = f;
+	}
+      }
+    }
+
+    /* found best first: print them by frame count */
+    for ( k = 1; ( k < STACK_KNEES ) && knees[k]; k++ ) {
+      for ( f = knees[k], i = k; ( i > 0 ) && ( knees[i - 1] > f ); i-- )
+	knees[i] = knees[i - 1];
+      knees[i] = f;
+    }
+
+    fprintf( out, "knees:" );
+    for ( k = 0; ( k < STACK_KNEES ) && knees[k]; k++ )
+      fprintf( out, " %u frames (%llu faults)", knees[k], (unsigned long long)faults[knees[k]] );
+    fprintf( out, "\n" );
+
+    /* working set: frames to avoid a share of the avoidable faults */
+    avoidable = faults[0] - st.cold;
+    for ( k = 0; k < sizeof(cover) / sizeof(cover[0]); k++ ) {
+      for ( f = 1; ( f < st.distinct ) && ( faults[0] - faults[f] < cover[k] * avoidable ); f++ );
+      fprintf( out, "%2.0f%% of avoidable faults avoided with %u frames\n", cover[k] * 100.0, f );
+    }
+  }
+
+  free( faults );
+  free( st.pages );
+  free( st.tree );
+  free( st.owner );
+  free( st.hist );
+
+  return err;
+}
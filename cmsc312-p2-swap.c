@@ -0,0 +1,631 @@
+/**********************************************************************
+
+   File          : cmsc312-p2-swap.c
+
+   Description   : A real swap file.  Frames hold page contents (a tag
+                   naming the page, then its count of writes), so a page
+                   read back can be checked.  A page written out gets a
+                   slot in the file; slots are handed out next fit from a
+                   cursor, in runs, so that consecutive page-outs land
+                   next to each other; once the file is twice the slots
+                   in use, a shorter run is taken before the file grows.
+                   Evicted dirty pages wait in a queue over a reserved
+                   run of (up to) swap_batch slots and go out in one
+                   pwritev; a fault on a queued page is served from the
+                   queue.  The file is unlinked once open, so it goes
+                   away however the run ends.  With swap_direct it is
+                   opened O_DIRECT | O_DSYNC, so the times are the
+                   device's rather than the page cache's.  A page keeps its slot while its copy
+                   is current, and gives it up when it is written again.
+                   The time of every read and write is measured
+                   (see .h for applications)
+
+***********************************************************************/
+/**********************************************************************
+Copyright (c) 2016 The Pennsylvania State University
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of The Pennsylvania State University nor the names of its contributors may be used to endorse or promote products derived from this softwiare without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* Include Files */
+#define _GNU_SOURCE             /* O_DIRECT */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <assert.h>
+
+/* Project Include Files */
+#include "cmsc312-p2.h"
+
+/* Definitions */
+#define SWAP_DIR_MIN  1024          /* pages with slots, first allocation */
+#define SWAP_SLOTS_MIN 1024         /* slots, first allocation and growth step */
+#define SWAP_ALIGN    4096          /* buffer alignment for O_DIRECT */
+
+/* each machine gets its own file, path.N */
+static int swap_files = 0;
+
+
+/**********************************************************************
+
+    Function    : swap_now
+    Description : monotonic clock, for timing the file's reads and writes
+    Inputs      : none
+    Outputs     : time in ns
+
+***********************************************************************/
+
+static uint64_t swap_now( void )
+{
+  struct timespec ts;
+
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+/**********************************************************************
+
+    Function    : swap_init
+    Description : create the current machine's swap file and the frames'
+                  contents
+    Inputs      : none
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int swap_init( void )
+{
+  swapdev_t *s = (swapdev_t *)calloc( 1, sizeof(swapdev_t) );
+  int n;
+
+  if (( sim->swap = s ) == NULL )
+    return -1;
+
+  s->fd = -1;
+  n = __sync_fetch_and_add( &swap_files, 1 );
+  if (( s->path = (char *)malloc( strlen( swap_path ) + 16 )) == NULL )
+    return -1;
+  sprintf( s->path, "%s.%d", swap_path, n );
+
+  if (( s->fd = open( s->path, O_RDWR | O_CREAT | O_TRUNC |
+		      ( swap_direct ? O_DIRECT | O_DSYNC : 0 ), 0600 )) < 0 ) {
+    fprintf( stderr, "swap: cannot create %s: %s\n", s->path, strerror( errno ));
+    return -1;
+  }
+  unlink( s->path );
+
+  /* page contents are aligned for O_DIRECT */
+  if ( posix_memalign( (void **)&s->data, SWAP_ALIGN, (size_t)sim->frames * page_size ) ||
+       posix_memalign( (void **)&s->queue, SWAP_ALIGN, (size_t)swap_batch * page_size ))
+    return -1;
+  memset( s->data, 0, (size_t)sim->frames * page_size );
+
+  s->slots = SWAP_SLOTS_MIN;
+  s->used = (uint64_t *)calloc( BITMAP_WORDS( s->slots ), sizeof(uint64_t) );
+  s->slot = (int *)malloc( sizeof(int) * SWAP_DIR_MIN );
+  s->stamp = (uint64_t *)malloc( sizeof(uint64_t) * SWAP_DIR_MIN );
+  s->queued = (int *)malloc( sizeof(int) * swap_batch );
+  s->iov = (struct iovec *)malloc( sizeof(struct iovec) * swap_batch );
+
+  if (( s->used == NULL ) || ( s->slot == NULL ) || ( s->stamp == NULL ) || ( s->queued == NULL ) ||
+      ( s->iov == NULL ) || qdir_init( &s->dir, SWAP_DIR_MIN ))
+    return -1;
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : swap_exit
+    Description : close the swap file and free its state
+    Inputs      : none
+    Outputs     : none
+
+***********************************************************************/
+
+void swap_exit( void )
+{
+  swapdev_t *s = sim->swap;
+
+  if ( s == NULL )
+    return;
+
+  if ( s->fd >= 0 )
+    close( s->fd );
+
+  if ( s->slot )
+    qdir_free( &s->dir );
+  free( s->path );
+  free( s->data );
+  free( s->used );
+  free( s->slot );
+  free( s->stamp );
+  free( s->queue );
+  free( s->queued );
+  free( s->iov );
+  free( s );
+  sim->swap = NULL;
+}
+
+
+/**********************************************************************
+
+    Function    : swap_page
+    Description : contents of a frame
+    Inputs      : frame - frame number
+    Outputs     : the frame's page_size bytes
+
+***********************************************************************/
+
+static inline char *swap_page( int frame )
+{
+  return sim->swap->data + (size_t)frame * page_size;
+}
+
+
+/**********************************************************************
+
+    Function    : swap_tag
+    Description : the tag a page's contents start with
+    Inputs      : pid - process id
+                  page - page number
+    Outputs     : tag
+
+***********************************************************************/
+
+static inline uint64_t swap_tag( int pid, vpn_t page )
+{
+  return ((uint64_t)pid << 52 ) ^ page;
+}
+
+
+/**********************************************************************
+
+    Function    : swap_find
+    Description : find a run of free slots within a range
+    Inputs      : from - first slot to look at
+                  to - slot to stop before
+                  n - slots
+    Outputs     : first slot of the run, or -1 if there is none
+
+***********************************************************************/
+
+static int swap_find( int from, int to, int n )
+{
+  swapdev_t *s = sim->swap;
+  int i, run = 0;
+
+  for ( i = from; i < to; i++ ) {
+    /* a full word holds no free slot */
+    if ((( i & 63 ) == 0 ) && ( s->used[i >> 6] == ~0ULL )) {
+      i += 63;
+      run = 0;
+    }
+    else if ( BITMAP_TEST( s->used, i ))
+      run = 0;
+    else if ( ++run == n )
+      return i - n + 1;
+  }
+
+  return -1;
+}
+
+
+/**********************************************************************
+
+    Function    : swap_alloc
+    Description : take a run of free slots, next fit from the cursor;
+                  the longest run wanted is taken if free, else shorter
+                  ones, with the file growing only while it is not yet
+                  twice the slots in use (or when no slot is free)
+    Inputs      : want - slots wanted
+                  got - slots taken (out)
+    Outputs     : first slot of the run, or -1 if out of memory
+
+***********************************************************************/
+
+static int swap_alloc( int want, int *got )
+{
+  swapdev_t *s = sim->swap;
+  uint64_t *used;
+  int start = -1, words, n, i;
+
+  for ( n = want; n >= 1; n /= 2 ) {
+    /* from the cursor to the end, then from the start up to the cursor */
+    if ((( start = swap_find( s->cursor, s->slots, n )) >= 0 ) ||
+	(( start = swap_find( 0, ( s->cursor + n - 1 < s->slots ) ? s->cursor + n - 1 : s->slots, n )) >= 0 ) ||
+	( s->slots < 2 * ( s->in_use + n )))
+      break;
+  }
+  if ( n == 0 )
+    n = 1;
+
+  /* no run free: the file grows, past the last slot in use */
+  if ( start < 0 ) {
+    for ( start = s->slots; ( start > 0 ) && !BITMAP_TEST( s->used, start - 1 ); start-- );
+    words = BITMAP_WORDS( s->slots );
+    s->slots = ( start + n + SWAP_SLOTS_MIN - 1 ) / SWAP_SLOTS_MIN * SWAP_SLOTS_MIN;
+    if (( used = (uint64_t *)realloc( s->used, sizeof(uint64_t) * BITMAP_WORDS( s->slots ))) == NULL )
+      return -1;
+    s->used = used;
+    memset( s->used + words, 0, sizeof(uint64_t) * ( BITMAP_WORDS( s->slots ) - words ));
+  }
+
+  for ( i = start; i < start + n; i++ )
+    BITMAP_SET( s->used, i );
+  s->in_use += n;
+  if ( s->in_use > s->peak )
+    s->peak = s->in_use;
+  s->cursor = start + n;
+  *got = n;
+
+  return start;
+}
+
+
+/**********************************************************************
+
+    Function    : swap_release
+    Description : give a slot back
+    Inputs      : slot - slot number
+    Outputs     : none
+
+***********************************************************************/
+
+static void swap_release( int slot )
+{
+  BITMAP_CLEAR( sim->swap->used, slot );
+  sim->swap->in_use--;
+}
+
+
+/**********************************************************************
+
+    Function    : swap_entry
+    Description : the directory entry of a page about to be written,
+                  adding one (and growing the directory) if it has none
+    Inputs      : pid - process id
+                  page - page number
+    Outputs     : entry, or QLIST_NONE if out of memory
+
+***********************************************************************/
+
+static int swap_entry( int pid, vpn_t page )
+{
+  swapdev_t *s = sim->swap;
+  uint64_t *stamp;
+  int *slot;
+  int e;
+
+  if (( e = qdir_find( &s->dir, pid, page )) != QLIST_NONE )
+    return e;
+
+  if ( s->dir.nfree == 0 ) {
+    if ( qdir_grow( &s->dir ))
+      return QLIST_NONE;
+    if (( slot = (int *)realloc( s->slot, sizeof(int) * s->dir.n )) == NULL )
+      return QLIST_NONE;
+    s->slot = slot;
+    if (( stamp = (uint64_t *)realloc( s->stamp, sizeof(uint64_t) * s->dir.n )) == NULL )
+      return QLIST_NONE;
+    s->stamp = stamp;
+  }
+
+  return qdir_add( &s->dir, pid, page );
+}
+
+
+/**********************************************************************
+
+    Function    : swap_pwritev
+    Description : write pages to a run of slots with one call, timed
+    Inputs      : first - first slot
+                  n - pages, in s->iov
+    Outputs     : ns taken, or 0 on error
+
+***********************************************************************/
+
+static uint64_t swap_pwritev( int first, int n )
+{
+  swapdev_t *s = sim->swap;
+  uint64_t t = swap_now( );
+  ssize_t done;
+
+  done = pwritev( s->fd, s->iov, n, (off_t)first * page_size );
+  if ( done != (ssize_t)n * page_size ) {
+    fprintf( stderr, "swap: write to %s failed: %s\n", s->path,
+	     ( done < 0 ) ? strerror( errno ) : "short write" );
+    return 0;
+  }
+
+  t = swap_now( ) - t;
+  s->writes++;
+  s->write_pages += n;
+  s->write_ns += t;
+  if ( first == s->next )
+    s->seq_writes++;
+  s->next = first + n;
+
+  return t ? t : 1;
+}
+
+
+/**********************************************************************
+
+    Function    : swap_flush
+    Description : write the queued evicted pages out together, and give
+                  back the reserved slots they did not use
+    Inputs      : none
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int swap_flush( void )
+{
+  swapdev_t *s = sim->swap;
+  uint64_t t;
+  int i;
+
+  if ( s->nqueued == 0 )
+    return 0;
+
+  for ( i = 0; i < s->nqueued; i++ ) {
+    s->iov[i].iov_base = s->queue + (size_t)i * page_size;
+    s->iov[i].iov_len = page_size;
+  }
+
+  if (( t = swap_pwritev( s->qslot, s->nqueued )) == 0 )
+    return -1;
+  s->evict_ns += t;
+
+  /* pages written again while queued no longer need their slots */
+  for ( i = 0; i < s->nqueued; i++ ) {
+    if ( s->queued[i] == QLIST_NONE )
+      swap_release( s->qslot + i );
+  }
+  for ( i = s->nqueued; i < s->qlen; i++ )
+    swap_release( s->qslot + i );
+
+  /* the next run continues where this one stopped */
+  if ( s->cursor == s->qslot + s->qlen )
+    s->cursor = s->qslot + s->nqueued;
+  s->nqueued = 0;
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : swap_out
+    Description : an evicted dirty page joins the write queue, taking
+                  the next slot of its run
+    Inputs      : f - frame of the page
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int swap_out( frame_t *f )
+{
+  swapdev_t *s = sim->swap;
+  int e;
+
+  if (( s->nqueued == 0 ) && (( s->qslot = swap_alloc( swap_batch, &s->qlen )) < 0 ))
+    return -1;
+
+  if (( e = swap_entry( f->pid, f->page )) == QLIST_NONE )
+    return -1;
+
+  s->slot[e] = s->qslot + s->nqueued;
+  s->stamp[e] = ((uint64_t *)swap_page( f->number ))[1];
+  memcpy( s->queue + (size_t)s->nqueued * page_size, swap_page( f->number ), page_size );
+  s->queued[s->nqueued++] = e;
+
+  return ( s->nqueued == s->qlen ) ? swap_flush( ) : 0;
+}
+
+
+/**********************************************************************
+
+    Function    : swap_clean
+    Description : write resident dirty pages (the cleaner's) to runs of
+                  slots, one call per run; they stay resident, now clean
+    Inputs      : f - frames
+                  n - number of frames
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int swap_clean( frame_t **f, int n )
+{
+  swapdev_t *s = sim->swap;
+  int first, got, e, i;
+
+  for ( ; n > 0; n -= got, f += got ) {
+    if (( first = swap_alloc( n, &got )) < 0 )
+      return -1;
+
+    for ( i = 0; i < got; i++ ) {
+      if (( e = swap_entry( f[i]->pid, f[i]->page )) == QLIST_NONE )
+	return -1;
+      s->slot[e] = first + i;
+      s->stamp[e] = ((uint64_t *)swap_page( f[i]->number ))[1];
+      s->iov[i].iov_base = swap_page( f[i]->number );
+      s->iov[i].iov_len = page_size;
+    }
+
+    if ( swap_pwritev( first, got ) == 0 )
+      return -1;
+  }
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : swap_in
+    Description : fill a frame with its new page: read from the page's
+                  slot (or its place in the write queue), or made fresh
+                  on the first touch; a page read back is checked
+                  against its tag and the write count its copy was
+                  written with
+    Inputs      : f - frame, already holding the page's pid and number
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int swap_in( frame_t *f )
+{
+  swapdev_t *s = sim->swap;
+  char *data = swap_page( f->number );
+  uint64_t t;
+  struct iovec iov;
+  int e, slot;
+
+  if (( e = qdir_find( &s->dir, f->pid, f->page )) == QLIST_NONE ) {
+    memset( data, 0, page_size );
+    ((uint64_t *)data)[0] = swap_tag( f->pid, f->page );
+    s->fills++;
+    return 0;
+  }
+
+  slot = s->slot[e];
+  if ( s->nqueued && ( slot >= s->qslot ) && ( slot < s->qslot + s->nqueued )) {
+    memcpy( data, s->queue + (size_t)( slot - s->qslot ) * page_size, page_size );
+    s->queue_hits++;
+  }
+  else {
+    iov.iov_base = data;
+    iov.iov_len = page_size;
+    t = swap_now( );
+    if ( preadv( s->fd, &iov, 1, (off_t)slot * page_size ) != page_size ) {
+      fprintf( stderr, "swap: read from %s failed\n", s->path );
+      return -1;
+    }
+    s->read_ns += swap_now( ) - t;
+    s->reads++;
+  }
+
+  /* the right page, and its last write rather than an older copy */
+  if (( ((uint64_t *)data)[0] != swap_tag( f->pid, f->page )) ||
+      ( ((uint64_t *)data)[1] != s->stamp[e] ))
+    s->mismatches++;
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : swap_stamp
+    Description : a write to the page in a frame changes its contents
+    Inputs      : frame - frame number
+    Outputs     : none
+
+***********************************************************************/
+
+void swap_stamp( int frame )
+{
+  ((uint64_t *)swap_page( frame ))[1]++;
+}
+
+
+/**********************************************************************
+
+    Function    : swap_dirtied
+    Description : the page in a frame became dirty: its copy in the file
+                  is stale, so its slot is given up
+    Inputs      : f - frame
+    Outputs     : none
+
+***********************************************************************/
+
+void swap_dirtied( frame_t *f )
+{
+  swapdev_t *s = sim->swap;
+  int e, slot;
+
+  if (( e = qdir_find( &s->dir, f->pid, f->page )) == QLIST_NONE )
+    return;
+
+  /* a queued copy is still written; its slot comes back after that */
+  slot = s->slot[e];
+  if ( s->nqueued && ( slot >= s->qslot ) && ( slot < s->qslot + s->nqueued ))
+    s->queued[slot - s->qslot] = QLIST_NONE;
+  else
+    swap_release( slot );
+
+  qdir_del( &s->dir, e );
+}
+
+
+/**********************************************************************
+
+    Function    : swap_write
+    Description : Write the swap file's activity, measured next to the
+                  modeled times
+    Inputs      : out - file pointer of output file
+    Outputs     : none
+
+***********************************************************************/
+
+void swap_write( FILE *out )
+{
+  swapdev_t *s = sim->swap;
+  double write_ms = s->writes ? s->write_ns / 1e6 / s->writes : 0.0;
+  double page_ms = s->write_pages ? s->write_ns / 1e6 / s->write_pages : 0.0;
+  double read_ms = s->reads ? s->read_ns / 1e6 / s->reads : 0.0;
+  double modeled, measured;
+
+  fprintf( out, "++++++++++++++++++++ Swap File ++++++++++++++++++\n" );
+  fprintf( out, "swap file: %s (%s); %d slots of %d bytes (peak %d in use); evictions written up to %d at a time\n",
+	   s->path, swap_direct ? "direct I/O" : "through the page cache", s->slots, page_size,
+	   s->peak, swap_batch );
+  fprintf( out, "page-outs: %llu writes of %llu pages (%.2f pages each); %llu starting where the last ended\n",
+	   (unsigned long long)s->writes, (unsigned long long)s->write_pages,
+	   s->writes ? (double)s->write_pages / s->writes : 0.0, (unsigned long long)s->seq_writes );
+  fprintf( out, "page-ins: %llu reads; %llu from the write queue; %llu first touches; %llu pages not as written\n",
+	   (unsigned long long)s->reads, (unsigned long long)s->queue_hits,
+	   (unsigned long long)s->fills, (unsigned long long)s->mismatches );
+  fprintf( out, "measured: %.4fms per write (%.4fms per page), %.4fms per read\n",
+	   write_ms, page_ms, read_ms );
+  fprintf( out, "modeled:  %dms per page out, %dms per page in\n", SWAP_OUT_OVERHEAD, SWAP_IN_OVERHEAD );
+
+  /* a fault's service: trap and restart, its read, and its share of
+     the evicted pages' writes (the cleaner's are off the fault path) */
+  if ( sim->pfs ) {
+    modeled = PF_OVERHEAD + SWAP_IN_OVERHEAD + RESTART_OVERHEAD +
+      (double)sim->swaps / sim->pfs * SWAP_OUT_OVERHEAD;
+    measured = PF_OVERHEAD + RESTART_OVERHEAD +
+      ( s->read_ns + s->evict_ns ) / 1e6 / sim->pfs;
+    fprintf( out, "page-fault service: %.4fms with measured I/O; %.4fms modeled\n", measured, modeled );
+  }
+}
@@ -0,0 +1,420 @@
+/**********************************************************************
+
+   File          : cmsc312-p2-sweep.c
+
+   Description   : This is the parameter sweep: every combination of
+                   replacement mechanism, frame count, and TLB size is
+                   a job that replays the trace on its own machine.  The
+                   trace is decoded once into memory that all jobs read.
+                   Jobs run on a pool of threads, each with a deque of
+                   jobs; a thread whose deque runs dry steals from the
+                   front of the others
+                   (see .h for applications)
+
+***********************************************************************/
+/**********************************************************************
+Copyright (c) 2016 The Pennsylvania State University
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of The Pennsylvania State University nor the names of its contributors may be used to endorse or promote products derived from this softwiare without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* Include Files */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <assert.h>
+#include <pthread.h>
+
+/* Project Include Files */
+#include "cmsc312-p2.h"
+
+/* Definitions */
+
+/* one configuration and its results */
+typedef struct sweep_job {
+  int mech;
+  int frames;
+  int entries;
+  int err;
+  uint64_t accesses;
+  uint64_t pfs;
+  uint64_t swaps;
+  uint64_t invalidates;
+  float tlb_hit_ratio;
+  float mem_access_time;
+  float pf_ratio;
+  float access_time;
+} sweep_job_t;
+
+/* a thread's jobs: it takes from the back, thieves from the front */
+typedef struct sweep_deque {
+  pthread_mutex_t lock;
+  int *jobs;
+  int head;
+  int tail;
+} sweep_deque_t;
+
+typedef struct sweep {
+  trace_t *tr;                  /* shared records */
+  sweep_job_t *jobs;
+  sweep_deque_t *deques;
+  int threads;
+} sweep_t;
+
+typedef struct sweep_worker {
+  sweep_t *sw;
+  int id;
+} sweep_worker_t;
+
+
+/**********************************************************************
+
+    Function    : sweep_list
+    Description : parse a list of values: "a,b,c" or a doubling range
+                  "lo-hi" (lo, 2lo, 4lo, ... up to hi), or a mix
+    Inputs      : arg - list text
+                  vals - values, allocated here (out)
+    Outputs     : number of values, or -1 if malformed
+
+***********************************************************************/
+
+int sweep_list( const char *arg, int **vals )
+{
+  const char *p = arg;
+  char *end;
+  long lo, hi, v;
+  int n = 0, cap = 16;
+  int *more;
+
+  if (( *vals = (int *)malloc( sizeof(int) * cap )) == NULL )
+    return -1;
+
+  while ( TRUE ) {
+    errno = 0;
+    lo = hi = strtol( p, &end, 0 );
+    if (( end != p ) && ( *end == '-' )) {
+      p = end + 1;
+      hi = strtol( p, &end, 0 );
+    }
+    if ( errno || ( end == p ) || ( lo < 1 ) || ( hi < lo ) || ( hi > 0x7fffffff ) ||
+	 (( *end != ',' ) && ( *end != '\0' )))
+      break;
+
+    for ( v = lo; v <= hi; v *= 2 ) {
+      if ( n == cap ) {
+	cap *= 2;
+	if (( more = (int *)realloc( *vals, sizeof(int) * cap )) == NULL )
+	  break;
+	*vals = more;
+      }
+      (*vals)[n++] = (int)v;
+    }
+
+    if ( *end == '\0' )
+      return n;
+    p = end + 1;
+  }
+
+  fprintf( stderr, "sweep: bad list %s\n", arg );
+  free( *vals );
+  *vals = NULL;
+  return -1;
+}
+
+
+/**********************************************************************
+
+    Function    : sweep_run_job
+    Description : replay the trace on a new machine for one configuration
+    Inputs      : sw - sweep
+                  job - configuration, and its results (out)
+    Outputs     : none
+
+***********************************************************************/
+
+static void sweep_run_job( sweep_t *sw, sweep_job_t *job )
+{
+  trace_t *view;
+  int pid, op;
+  vaddr_t vaddr;
+  float walk;
+
+  job->err = -1;
+
+  if (( view = trace_view( sw->tr )) == NULL )
+    return;
+
+  if ( sim_create( view, job->mech, job->frames, job->entries ) == NULL ) {
+    trace_close( view );
+    return;
+  }
+
+  while ( trace_next( view, &pid, &vaddr, &op ) > 0 ) {
+    if ( sim_access( pid, vaddr, op ))
+      break;
+  }
+
+  /* load control may still hold references at the end */
+  if (( view->cur == view->end ) && !sim_finish( )) {
+    sim_times( &job->tlb_hit_ratio, &walk, &job->mem_access_time,
+	       &job->pf_ratio, &job->access_time );
+    job->accesses = sim->total_accesses;
+    job->pfs = sim->pfs;
+    job->swaps = sim->swaps;
+    job->invalidates = sim->invalidates;
+    job->err = 0;
+  }
+
+  sim_destroy( sim );
+  trace_close( view );
+}
+
+
+/**********************************************************************
+
+    Function    : sweep_take
+    Description : take the next job: from the back of our own deque,
+                  else from the front of another thread's
+    Inputs      : sw - sweep
+                  id - our thread
+    Outputs     : job index, or -1 when every deque is empty
+
+***********************************************************************/
+
+static int sweep_take( sweep_t *sw, int id )
+{
+  sweep_deque_t *dq;
+  int i, job = -1;
+
+  for ( i = 0; ( job < 0 ) && ( i < sw->threads ); i++ ) {
+    dq = &sw->deques[( id + i ) % sw->threads];
+
+    pthread_mutex_lock( &dq->lock );
+    if ( dq->head < dq->tail )
+      job = ( i == 0 ) ? dq->jobs[--dq->tail] : dq->jobs[dq->head++];
+    pthread_mutex_unlock( &dq->lock );
+  }
+
+  return job;
+}
+
+
+/**********************************************************************
+
+    Function    : sweep_worker
+    Description : run jobs until there are none left anywhere
+    Inputs      : arg - the worker
+    Outputs     : NULL
+
+***********************************************************************/
+
+static void *sweep_worker( void *arg )
+{
+  sweep_worker_t *w = (sweep_worker_t *)arg;
+  int job;
+
+  while (( job = sweep_take( w->sw, w->id )) >= 0 )
+    sweep_run_job( w->sw, &w->sw->jobs[job] );
+
+  return NULL;
+}
+
+
+/**********************************************************************
+
+    Function    : sweep_check
+    Description : check every reference once, rather than once per job
+    Inputs      : tr - mapped or in-memory trace
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+static int sweep_check( trace_t *tr )
+{
+  const trace_rec_t *rec;
+  const unsigned char *p;
+
+  for ( p = tr->start; p < tr->end; p += tr->recsize ) {
+    rec = (const trace_rec_t *)p;
+    if ( rec->pid >= (uint32_t)max_processes ) {
+      fprintf( stderr, "bad pid %d in trace\n", (int)rec->pid );
+      return -1;
+    }
+    if (( va_bits < 64 ) && ( rec->vaddr >> va_bits )) {
+      fprintf( stderr, "bad vaddr 0x%llx in trace (beyond %d bits)\n",
+	       (unsigned long long)rec->vaddr, va_bits );
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : sweep_threads
+    Description : deal the jobs out to the threads' deques round robin
+                  (stealing evens out the rest), and run them
+    Inputs      : sw - sweep, with its jobs filled in
+                  njobs - number of jobs
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+static int sweep_threads( sweep_t *sw, int njobs )
+{
+  sweep_worker_t *workers = (sweep_worker_t *)calloc( sw->threads, sizeof(sweep_worker_t) );
+  pthread_t *tids = (pthread_t *)calloc( sw->threads, sizeof(pthread_t) );
+  sweep_deque_t *dq;
+  int i, n, started, err = 0;
+
+  if (( workers == NULL ) || ( tids == NULL ))
+    err = -1;
+
+  for ( i = 0; !err && ( i < sw->threads ); i++ ) {
+    pthread_mutex_init( &sw->deques[i].lock, NULL );
+    sw->deques[i].jobs = (int *)malloc( sizeof(int) * ( njobs / sw->threads + 1 ));
+    if ( sw->deques[i].jobs == NULL )
+      err = -1;
+  }
+
+  if ( !err ) {
+    for ( n = 0; n < njobs; n++ ) {
+      dq = &sw->deques[n % sw->threads];
+      dq->jobs[dq->tail++] = n;
+    }
+
+    for ( started = 0; started < sw->threads; started++ ) {
+      workers[started].sw = sw;
+      workers[started].id = started;
+      if ( pthread_create( &tids[started], NULL, sweep_worker, &workers[started] ))
+	break;
+    }
+
+    /* no threads at all: run the jobs here */
+    if ( started == 0 )
+      sweep_worker( &workers[0] );
+    for ( i = 0; i < started; i++ )
+      pthread_join( tids[i], NULL );
+  }
+
+  for ( i = 0; i < sw->threads; i++ ) {
+    free( sw->deques[i].jobs );
+    pthread_mutex_destroy( &sw->deques[i].lock );
+  }
+  free( workers );
+  free( tids );
+
+  return err;
+}
+
+
+/**********************************************************************
+
+    Function    : sweep_run
+    Description : run every combination of mechanism, frame count, and
+                  TLB size over the trace and write a CSV row for each
+    Inputs      : tr - input trace, at its first reference
+                  mechs, nmechs - replacement mechanisms
+                  frames, nframes - frame counts
+                  entries, nentries - TLB sizes
+                  threads - worker threads (0 for one per CPU)
+                  out - CSV output
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int sweep_run( trace_t *tr, int *mechs, int nmechs, int *frames, int nframes,
+	       int *entries, int nentries, int threads, FILE *out )
+{
+  sweep_t sw;
+  sweep_job_t *job;
+  trace_t *mt = NULL;
+  int njobs = nmechs * nframes * nentries;
+  int i, j, k, n, err = 0;
+
+  /* decode once; binary trace files are already mapped */
+  if ( tr->map )
+    sw.tr = tr;
+  else if (( sw.tr = mt = trace_load( tr )) == NULL ) {
+    fprintf( stderr, "sweep: cannot load trace\n" );
+    return -1;
+  }
+
+  if ( threads <= 0 )
+    threads = (int)sysconf( _SC_NPROCESSORS_ONLN );
+  if ( threads > njobs )
+    threads = njobs;
+  if ( threads < 1 )
+    threads = 1;
+
+  sw.threads = threads;
+  sw.jobs = (sweep_job_t *)calloc( njobs, sizeof(sweep_job_t) );
+  sw.deques = (sweep_deque_t *)calloc( threads, sizeof(sweep_deque_t) );
+
+  if (( sw.jobs == NULL ) || ( sw.deques == NULL ) || sweep_check( sw.tr ))
+    err = -1;
+
+  if ( !err ) {
+    for ( i = 0, n = 0; i < nmechs; i++ ) {
+      for ( j = 0; j < nframes; j++ ) {
+	for ( k = 0; k < nentries; k++, n++ ) {
+	  sw.jobs[n].mech = mechs[i];
+	  sw.jobs[n].frames = frames[j];
+	  sw.jobs[n].entries = entries[k];
+	}
+      }
+    }
+    err = sweep_threads( &sw, njobs );
+  }
+
+  if ( !err ) {
+    fprintf( out, "mech,frames,tlb_entries,accesses,faults,fault_ratio,swaps,invalidates,"
+	     "tlb_hit_ratio,mem_access_ns,access_ms\n" );
+    for ( n = 0; n < njobs; n++ ) {
+      job = &sw.jobs[n];
+      if ( job->err ) {
+	fprintf( stderr, "sweep: %s with %d frames and %d TLB entries failed\n",
+		 pt_mech_names[job->mech], job->frames, job->entries );
+	err = -1;
+	continue;
+      }
+      fprintf( out, "%s,%d,%d,%llu,%llu,%f,%llu,%llu,%f,%f,%f\n", pt_mech_names[job->mech],
+	       job->frames, job->entries, (unsigned long long)job->accesses,
+	       (unsigned long long)job->pfs, job->pf_ratio, (unsigned long long)job->swaps,
+	       (unsigned long long)job->invalidates, job->tlb_hit_ratio, job->mem_access_time,
+	       job->access_time );
+    }
+  }
+
+  free( sw.deques );
+  free( sw.jobs );
+  if ( mt )
+    trace_close( mt );
+
+  return err;
+}
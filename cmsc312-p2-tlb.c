@@ -0,0 +1,612 @@
+/**********************************************************************
+
+   File          : cmsc312-p2-tlb.c
+
+   Description   : This is the simulated TLB.  Entries live in sets
+                   chosen by a hash of the page (and address space), and
+                   may be tagged with an address-space ID so they survive
+                   context switches.  A tagged TLB has an untagged one
+                   running alongside, so the results can compare the two
+                   context switch modes on the same trace
+                   (see .h for applications)
+
+***********************************************************************/
+/**********************************************************************
+Copyright (c) 2016 The Pennsylvania State University
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of The Pennsylvania State University nor the names of its contributors may be used to endorse or promote products derived from this softwiare without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* Include Files */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <assert.h>
+
+/* Project Include Files */
+#include "cmsc312-p2.h"
+
+/* Definitions */
+
+
+/**********************************************************************
+
+    Function    : tlbc_create
+    Description : allocate a TLB and its per-process ASID table
+    Inputs      : tc - TLB
+                  asids - number of ASIDs, 0 for an untagged TLB
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+static int tlbc_create( tlbcache_t *tc, int asids )
+{
+  int i;
+
+  memset( tc, 0, sizeof(tlbcache_t) );
+  tc->asids = asids;
+  tc->pid = -1;
+  tc->generation = 1;   /* pid_gen starts at 0: no pid holds an ASID yet */
+  tc->entries = (tlb_t *)malloc( sizeof(tlb_t) * sim->tlb_entries );
+  tc->pid_asid = (int *)calloc( max_processes, sizeof(int) );
+  tc->pid_gen = (uint32_t *)calloc( max_processes, sizeof(uint32_t) );
+
+  if (( tc->entries == NULL ) || ( tc->pid_asid == NULL ) || ( tc->pid_gen == NULL ))
+    return -1;
+
+  for ( i = 0; i < sim->tlb_entries; i++ ) {
+    tc->entries[i].page = TLB_INVALID;
+    tc->entries[i].frame = TLB_INVALID;
+    tc->entries[i].op = TLB_INVALID;
+    tc->entries[i].stamp = 0;
+    tc->entries[i].mru = 0;
+    tc->entries[i].asid = 0;
+    tc->entries[i].huge = 0;
+    tc->entries[i].gen = 0;
+    tc->entries[i].pte = NULL;
+  }
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : tlb_init
+    Description : create the simulated TLB, and if it is tagged
+                  (tlb_tagged) the untagged TLB it is compared with
+    Inputs      : none
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int tlb_init( void )
+{
+  if ( tlbc_create( &sim->tlb, tlb_tagged ? tlb_asids : 0 ) ||
+       ( tlb_tagged && tlbc_create( &sim->tlb_shadow, 0 )))
+    return -1;
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : tlb_exit
+    Description : free both TLBs
+    Inputs      : none
+    Outputs     : none
+
+***********************************************************************/
+
+void tlb_exit( void )
+{
+  tlbcache_t *tcs[2] = { &sim->tlb, &sim->tlb_shadow };
+  int i;
+
+  for ( i = 0; i < 2; i++ ) {
+    free( tcs[i]->entries );
+    free( tcs[i]->pid_asid );
+    free( tcs[i]->pid_gen );
+  }
+}
+
+
+/**********************************************************************
+
+    Function    : tlbc_flush
+    Description : invalidate every entry by starting a new generation;
+                  entries of older generations never match again
+    Inputs      : tc - TLB
+    Outputs     : none
+
+***********************************************************************/
+
+static void tlbc_flush( tlbcache_t *tc )
+{
+  tc->generation++;
+  tc->next_asid = 0;
+  tc->flushes++;
+}
+
+
+/**********************************************************************
+
+    Function    : tlb_flush
+    Description : flush the TLB (and the comparison TLB)
+    Inputs      : none
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int tlb_flush( void )
+{
+  tlbc_flush( &sim->tlb );
+  if ( sim->tlb.asids )
+    tlbc_flush( &sim->tlb_shadow );
+  
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : tlbc_switch
+    Description : make pid the running address space of a TLB.  An
+                  untagged TLB is flushed; a tagged one gives pid an ASID
+                  if it has none in this generation, starting a new
+                  generation when the ASIDs run out
+    Inputs      : tc - TLB
+                  pid - process id
+    Outputs     : none
+
+***********************************************************************/
+
+static void tlbc_switch( tlbcache_t *tc, int pid )
+{
+  if ( pid == tc->pid )
+    return;
+
+  tc->pid = pid;
+
+  if ( !tc->asids ) {
+    tlbc_flush( tc );
+    return;
+  }
+
+  if ( tc->pid_gen[pid] != tc->generation ) {
+    if ( tc->next_asid == tc->asids )
+      tlbc_flush( tc );
+    tc->pid_asid[pid] = tc->next_asid++;
+    tc->pid_gen[pid] = tc->generation;
+  }
+
+  tc->asid = tc->pid_asid[pid];
+}
+
+
+/**********************************************************************
+
+    Function    : tlb_switch
+    Description : context switch the TLB (and the comparison TLB) to pid
+    Inputs      : pid - process id
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int tlb_switch( int pid )
+{
+  tlbc_switch( &sim->tlb, pid );
+  if ( sim->tlb.asids )
+    tlbc_switch( &sim->tlb_shadow, pid );
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : tlbc_set
+    Description : find the first entry of the set a page maps to.  Pages
+                  (and ASIDs) are hashed so strided page numbers and
+                  different address spaces spread over sets
+    Inputs      : tc - TLB
+                  asid - address space
+                  page - page number (huge page number if huge)
+                  huge - base (0) or huge (1) page
+    Outputs     : first TLB entry of the set
+
+***********************************************************************/
+
+static tlb_t *tlbc_set( tlbcache_t *tc, int asid, vpn_t page, int huge )
+{
+  uint64_t h = ( page ^ ((uint64_t)asid << 48 ) ^ ((uint64_t)huge << 63 )) * 0x9E3779B97F4A7C15ULL;
+
+  return &tc->entries[(( h >> 32 ) & sim->tlb_set_mask ) * sim->tlb_ways];
+}
+
+
+/**********************************************************************
+
+    Function    : tlbc_live
+    Description : is an entry valid in the current generation?
+    Inputs      : tc - TLB
+                  e - entry
+    Outputs     : 1 if live, 0 otherwise
+
+***********************************************************************/
+
+static inline int tlbc_live( tlbcache_t *tc, tlb_t *e )
+{
+  return ( e->page != TLB_INVALID ) && ( e->gen == tc->generation );
+}
+
+
+/**********************************************************************
+
+    Function    : tlbc_touch
+    Description : record a use of a TLB entry for replacement in its set
+    Inputs      : tc - TLB
+                  set - first entry of the set
+                  e - entry used
+    Outputs     : none
+
+***********************************************************************/
+
+static void tlbc_touch( tlbcache_t *tc, tlb_t *set, tlb_t *e )
+{
+  int i;
+
+  if ( tlb_replacement == TLB_REPL_LRU ) {
+    e->stamp = ++tc->tick;
+    return;
+  }
+
+  /* bit pseudo-LRU: once every live way is marked, keep only the newest */
+  e->mru = 1;
+  for ( i = 0; i < sim->tlb_ways; i++ ) {
+    if ( !set[i].mru && tlbc_live( tc, &set[i] ))
+      return;
+  }
+  for ( i = 0; i < sim->tlb_ways; i++ )
+    set[i].mru = 0;
+  e->mru = 1;
+}
+
+
+/**********************************************************************
+
+    Function    : tlbc_find
+    Description : find the running address space's entry for a page in
+                  its set
+    Inputs      : tc - TLB
+                  page - page number (huge page number if huge)
+                  huge - base (0) or huge (1) page
+    Outputs     : entry, or NULL if none
+
+***********************************************************************/
+
+static tlb_t *tlbc_find( tlbcache_t *tc, vpn_t page, int huge )
+{
+  tlb_t *set = tlbc_set( tc, tc->asid, page, huge );
+  int i;
+
+  for ( i = 0; i < sim->tlb_ways; i++ ) {
+    if (( set[i].page == page ) && ( set[i].asid == tc->asid ) &&
+	( set[i].huge == huge ) && ( set[i].gen == tc->generation )) {
+      tlbc_touch( tc, set, &set[i] );
+      return &set[i];
+    }
+  }
+
+  return NULL;
+}
+
+
+/**********************************************************************
+
+    Function    : tlbc_lookup
+    Description : translate a page: a base page entry, or with huge pages
+                  on, the entry of the huge page holding it
+    Inputs      : tc - TLB
+                  page - page number
+                  frame - frame of the page on a hit
+                  pte - page table entry of the page on a hit
+    Outputs     : 1 if hit, 0 if miss
+
+***********************************************************************/
+
+static int tlbc_lookup( tlbcache_t *tc, vpn_t page, int *frame, ptentry_t **pte )
+{
+  vpn_t off = page & (( (vpn_t)1 << huge_order ) - 1 );
+  tlb_t *e;
+
+  tc->lookups++;
+
+  if (( e = tlbc_find( tc, page, 0 )) != NULL ) {
+    *frame = e->frame;
+    *pte = e->pte;
+  }
+  else if ( huge_pages && (( e = tlbc_find( tc, page >> huge_order, 1 )) != NULL )) {
+    *frame = e->frame + off;
+    *pte = e->pte + off;
+    tc->huge_hits++;
+  }
+  else
+    return 0;
+
+  tc->hits++;
+  return 1;
+}
+
+
+/**********************************************************************
+
+    Function    : tlbc_fill
+    Description : associate a page and its frame in a TLB, replacing
+                  the page's entry, a dead entry of its set, or else the
+                  set's (pseudo-)LRU entry
+    Inputs      : tc - TLB
+                  ptentry - page table entry of the (valid) page
+                  op - operation - read (0) or write (1)
+    Outputs     : none
+
+***********************************************************************/
+
+static void tlbc_fill( tlbcache_t *tc, ptentry_t *ptentry, int op )
+{
+  huge_region_t *r = huge_pages ? huge_region( ptentry ) : NULL;
+  int huge = r && r->huge;
+  vpn_t page = huge ? ( ptentry->number >> huge_order ) : ptentry->number;
+  tlb_t *set = tlbc_set( tc, tc->asid, page, huge );
+  tlb_t *e = NULL;
+  int i;
+
+  /* pages of a huge page share one entry for the whole of it */
+  if ( huge )
+    ptentry = r->first;
+
+  /* replace old entry */
+  for ( i = 0; i < sim->tlb_ways; i++ ) {
+    if (( set[i].page == page ) && ( set[i].asid == tc->asid ) &&
+	( set[i].huge == huge ) && ( set[i].gen == tc->generation )) {
+      e = &set[i];
+      break;
+    }
+  }
+
+  /* or add in a free (or flushed) way */
+  for ( i = 0; ( e == NULL ) && ( i < sim->tlb_ways ); i++ ) {
+    if ( !tlbc_live( tc, &set[i] ))
+      e = &set[i];
+  }
+
+  /* or evict the set's (pseudo-)least recently used entry */
+  if ( e == NULL ) {
+    e = &set[0];
+    for ( i = 1; i < sim->tlb_ways; i++ ) {
+      if (( tlb_replacement == TLB_REPL_LRU ) ? ( set[i].stamp < e->stamp ) : ( e->mru && !set[i].mru ))
+	e = &set[i];
+    }
+  }
+
+  e->page = page;
+  e->frame = ptentry->frame;
+  e->op = op;
+  e->pte = ptentry;
+  e->huge = huge;
+  e->asid = tc->asid;
+  e->gen = tc->generation;
+  e->mru = 0;
+  tlbc_touch( tc, set, e );
+}
+
+
+/**********************************************************************
+
+    Function    : tlb_shadow_ref
+    Description : replay a resolved access on the comparison TLB,
+                  filling it on a miss
+    Inputs      : ptentry - page table entry of the (now valid) page
+    Outputs     : 1 if hit, 0 if miss
+
+***********************************************************************/
+
+static int tlb_shadow_ref( ptentry_t *ptentry )
+{
+  ptentry_t *pte;
+  int frame;
+
+  if ( tlbc_lookup( &sim->tlb_shadow, ptentry->number, &frame, &pte ))
+    return 1;
+
+  tlbc_fill( &sim->tlb_shadow, ptentry, 0 );
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : tlb_resolve_addr
+    Description : convert vaddr to paddr if a hit in the tlb
+    Inputs      : vaddr - virtual address 
+                  paddr - physical address
+                  op - 0 for read, 1 for read-write
+    Outputs     : 1 if hit, 0 if miss
+
+***********************************************************************/
+
+/* note: normally, the operations associated with a page are based on the address space
+   segments in the ELF binary (read-only, read-write, execute-only).  Assume that this is 
+   already done */
+
+int tlb_resolve_addr( vaddr_t vaddr, uint64_t *paddr, int op )
+{
+  ptentry_t *pte;
+  int frame;
+
+  if ( tlbc_lookup( &sim->tlb, vaddr >> page_shift, &frame, &pte )) {
+    *paddr = ( (uint64_t)frame << page_shift ) + ( vaddr & page_mask );
+    EVENT( LOG_FULL, EV_TLB_HIT, sim->current_pid, vaddr, frame, 0 );
+    pt_count_ref( sim->current_pid, pte );
+    hw_update_pageref( pte, op );
+    if ( sim->tlb.asids )
+      tlb_shadow_ref( pte );
+    return 1;
+  }
+
+  EVENT( LOG_FULL, EV_TLB_MISS, sim->current_pid, vaddr, -1, 0 );
+  return 0;  /* miss */
+}
+
+
+/**********************************************************************
+
+    Function    : tlb_update_pageref
+    Description : associate a page and its frame in the TLB, after the
+                  page table resolved a miss (the comparison TLB sees
+                  the access too)
+    Inputs      : ptentry - page table entry of the (valid) page
+                  op - operation - read (0) or write (1)
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int tlb_update_pageref( ptentry_t *ptentry, int op )
+{
+  tlbc_fill( &sim->tlb, ptentry, op );
+  if ( sim->tlb.asids )
+    tlb_shadow_ref( ptentry );
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : tlbc_invalidate
+    Description : drop a process's entry for a page from a TLB.  Only
+                  the running process has entries in an untagged TLB,
+                  and only processes with an ASID in this generation in
+                  a tagged one
+    Inputs      : tc - TLB
+                  pid - process id
+                  page - page number (huge page number if huge)
+                  huge - base (0) or huge (1) page
+    Outputs     : none
+
+***********************************************************************/
+
+static void tlbc_invalidate( tlbcache_t *tc, int pid, vpn_t page, int huge )
+{
+  tlb_t *set;
+  int asid, i;
+
+  if ( tc->asids ) {
+    if ( tc->pid_gen[pid] != tc->generation )
+      return;
+    asid = tc->pid_asid[pid];
+  }
+  else {
+    if ( pid != tc->pid )
+      return;
+    asid = 0;
+  }
+
+  set = tlbc_set( tc, asid, page, huge );
+  for ( i = 0; i < sim->tlb_ways; i++ ) {
+    if (( set[i].page == page ) && ( set[i].asid == asid ) && ( set[i].huge == huge )) {
+      set[i].page = TLB_INVALID;
+      set[i].frame = TLB_INVALID;
+      set[i].op = TLB_INVALID;
+      set[i].stamp = 0;
+      set[i].mru = 0;
+      set[i].pte = NULL;
+    }
+  }
+}
+
+
+/**********************************************************************
+
+    Function    : tlb_invalidate_page
+    Description : drop the TLB entries for a page whose mapping went away
+    Inputs      : pid - process id
+                  page - page number
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int tlb_invalidate_page( int pid, vpn_t page )
+{
+  tlbc_invalidate( &sim->tlb, pid, page, 0 );
+  if ( sim->tlb.asids )
+    tlbc_invalidate( &sim->tlb_shadow, pid, page, 0 );
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : tlb_invalidate_huge
+    Description : drop the TLB entries for a huge page being demoted
+    Inputs      : pid - process id
+                  page - first (base) page of the huge page
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int tlb_invalidate_huge( int pid, vpn_t page )
+{
+  tlbc_invalidate( &sim->tlb, pid, page >> huge_order, 1 );
+  if ( sim->tlb.asids )
+    tlbc_invalidate( &sim->tlb_shadow, pid, page >> huge_order, 1 );
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : tlb_reach
+    Description : memory covered by a TLB's live entries
+    Inputs      : tc - TLB
+    Outputs     : bytes
+
+***********************************************************************/
+
+uint64_t tlb_reach( tlbcache_t *tc )
+{
+  uint64_t reach = 0;
+  int i;
+
+  for ( i = 0; i < sim->tlb_entries; i++ ) {
+    if ( tlbc_live( tc, &tc->entries[i] ))
+      reach += (uint64_t)page_size << ( tc->entries[i].huge ? huge_order : 0 );
+  }
+
+  return reach;
+}
@@ -0,0 +1,643 @@
+/**********************************************************************
+
+   File          : cmsc312-p2-trace.c
+
+   Description   : This is the memory trace reader/writer.  Traces are
+                   either the original text format ("pid vaddr" per line)
+                   or the fixed-width binary format.  Binary trace files
+                   are read through mmap with no per-record parsing;
+                   pipes, stdin and text traces are streamed through
+                   one buffer so the trace is only read once
+                   (see .h for applications)
+
+***********************************************************************/
+/**********************************************************************
+Copyright (c) 2016 The Pennsylvania State University
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of The Pennsylvania State University nor the names of its contributors may be used to endorse or promote products derived from this softwiare without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* Include Files */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <assert.h>
+
+/* Project Include Files */
+#include "cmsc312-p2.h"
+
+/* Definitions */
+
+
+/**********************************************************************
+
+    Function    : trace_text_op
+    Description : derive the operation for a text trace reference
+    Inputs      : vaddr - address of access
+    Outputs     : 1 for a write, 0 for a read
+
+***********************************************************************/
+
+int trace_text_op( vaddr_t vaddr )
+{
+  /* write: for certain addresses (< 0x200 into the page) */
+  return (( vaddr % page_size ) < 0x200 );
+}
+
+
+/**********************************************************************
+
+    Function    : trace_fill
+    Description : refill the stream buffer, keeping any unread bytes
+    Inputs      : tr - trace handle
+    Outputs     : number of unread bytes now buffered
+
+***********************************************************************/
+
+static size_t trace_fill( trace_t *tr )
+{
+  size_t left = tr->end - tr->cur;
+  ssize_t n;
+
+  memmove( tr->buf, tr->cur, left );
+  tr->cur = tr->buf;
+  tr->end = tr->buf + left;
+
+  while ( !tr->eof && ( left < TRACE_BUFSIZE )) {
+    n = read( tr->fd, tr->buf + left, TRACE_BUFSIZE - left );
+    if ( n < 0 && errno == EINTR )
+      continue;
+    if ( n <= 0 ) {
+      tr->eof = 1;
+      break;
+    }
+    left += n;
+    tr->end = tr->buf + left;
+  }
+
+  return left;
+}
+
+
+/**********************************************************************
+
+    Function    : trace_header_ok
+    Description : check whether bytes start a binary trace header
+    Inputs      : hdr - candidate header
+    Outputs     : 1 if a binary trace, 0 otherwise
+
+***********************************************************************/
+
+static int trace_header_ok( const trace_header_t *hdr )
+{
+  return (( hdr->magic == TRACE_MAGIC ) && ( hdr->version == TRACE_VERSION ) &&
+	  ( hdr->recsize >= sizeof(trace_rec_t) ) && ( hdr->recsize <= TRACE_BUFSIZE ));
+}
+
+
+/**********************************************************************
+
+    Function    : trace_count_ok
+    Description : check a binary header's record count against the size
+                  of the file, so a truncated or corrupt trace is caught
+                  before anyone sizes a table from the count
+    Inputs      : path - trace file name
+                  hdr - its header
+                  size - file size in bytes
+    Outputs     : 1 if the file holds every record the header counts
+
+***********************************************************************/
+
+static int trace_count_ok( char *path, const trace_header_t *hdr, off_t size )
+{
+  uint64_t held = ( size - sizeof(trace_header_t) ) / hdr->recsize;
+
+  if ( hdr->count <= held )
+    return 1;
+
+  fprintf( stderr, "trace: %s counts %llu references but holds only %llu\n",
+	   path, (unsigned long long)hdr->count, (unsigned long long)held );
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : trace_page_ok
+    Description : check that a binary trace whose ops were derived from
+                  its addresses (a converted text trace) was converted
+                  at the page size of this run, since a text trace's
+                  ops depend on it
+    Inputs      : path - trace file name
+                  hdr - its header
+    Outputs     : 1 if the ops hold at this page size
+
+***********************************************************************/
+
+static int trace_page_ok( char *path, const trace_header_t *hdr )
+{
+  if (( hdr->page_size == 0 ) || ( hdr->page_size == (uint32_t)page_size ))
+    return 1;
+
+  fprintf( stderr, "trace: %s was converted at %u-byte pages, not %d (convert it again with -s %d)\n",
+	   path, hdr->page_size, page_size, page_size );
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : trace_open
+    Description : open a trace.  Binary trace files are mapped, anything
+                  else (text, pipes, stdin) is streamed through a buffer
+    Inputs      : path - trace file name, or "-" for stdin
+    Outputs     : trace handle if successful, NULL otherwise
+
+***********************************************************************/
+
+trace_t *trace_open( char *path )
+{
+  trace_t *tr;
+  struct stat st;
+  trace_header_t hdr;
+  void *map;
+
+  tr = (trace_t *)malloc( sizeof(trace_t) );
+  if ( tr == NULL )
+    return NULL;
+  memset( tr, 0, sizeof(trace_t) );
+
+  if ( strcmp( path, "-" ) == 0 )
+    tr->fd = STDIN_FILENO;
+  else if (( tr->fd = open( path, O_RDONLY )) < 0 ) {
+    free( tr );
+    return NULL;
+  }
+
+  if (( fstat( tr->fd, &st ) == 0 ) && S_ISREG( st.st_mode ))
+    tr->seekable = 1;
+
+  /* binary trace files are read in place from the mapped pages */
+  if ( tr->seekable && ( st.st_size >= (off_t)sizeof(trace_header_t) )) {
+    map = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, tr->fd, 0 );
+
+    if ( map != MAP_FAILED ) {
+      if ( trace_header_ok( (trace_header_t *)map )) {
+	if ( !trace_count_ok( path, (trace_header_t *)map, st.st_size ) ||
+	     !trace_page_ok( path, (trace_header_t *)map )) {
+	  munmap( map, st.st_size );
+	  if ( tr->fd != STDIN_FILENO )
+	    close( tr->fd );
+	  free( tr );
+	  return NULL;
+	}
+
+	/* we consume records front to back: let the kernel read ahead
+	   aggressively and drop pages behind us */
+	madvise( map, st.st_size, MADV_SEQUENTIAL );
+	madvise( map, st.st_size, MADV_WILLNEED );
+
+	memcpy( &hdr, map, sizeof(hdr) );
+	tr->binary = 1;
+	tr->map = (unsigned char *)map;
+	tr->maplen = st.st_size;
+	tr->flags = hdr.flags;
+	tr->recsize = hdr.recsize;
+	tr->count = hdr.count;
+	tr->start = tr->map + sizeof(trace_header_t);
+	tr->end = tr->start + (( tr->maplen - sizeof(trace_header_t) ) / tr->recsize ) * tr->recsize;
+	tr->cur = tr->start;
+	return tr;
+      }
+
+      munmap( map, st.st_size );
+    }
+  }
+
+  /* otherwise stream it: sniff the header to tell binary from text */
+  if (( tr->buf = (unsigned char *)malloc( TRACE_BUFSIZE )) == NULL ) {
+    if ( tr->fd != STDIN_FILENO )
+      close( tr->fd );
+    free( tr );
+    return NULL;
+  }
+
+  tr->cur = tr->end = tr->start = tr->buf;
+  trace_fill( tr );
+
+  if ( tr->end - tr->cur >= (ssize_t)sizeof(trace_header_t) ) {
+    memcpy( &hdr, tr->cur, sizeof(hdr) );
+
+    if ( trace_header_ok( &hdr )) {
+      tr->binary = 1;
+      tr->flags = hdr.flags;
+      tr->recsize = hdr.recsize;
+      tr->cur += sizeof(trace_header_t);
+
+      /* a pipe's count cannot be checked: it is left unknown */
+      if ( !trace_page_ok( path, &hdr ) ||
+	   ( tr->seekable && !trace_count_ok( path, &hdr, st.st_size ))) {
+	if ( tr->fd != STDIN_FILENO )
+	  close( tr->fd );
+	free( tr->buf );
+	free( tr );
+	return NULL;
+      }
+      if ( tr->seekable )
+	tr->count = hdr.count;
+    }
+  }
+
+  return tr;
+}
+
+
+/**********************************************************************
+
+    Function    : trace_rewind
+    Description : reset the trace to its first reference
+    Inputs      : tr - trace handle
+    Outputs     : 0 if successful, <0 if the trace cannot be re-read
+
+***********************************************************************/
+
+int trace_rewind( trace_t *tr )
+{
+  if ( tr->map || tr->mem ) {
+    tr->cur = tr->start;
+    return 0;
+  }
+
+  if ( !tr->seekable || ( lseek( tr->fd, 0, SEEK_SET ) < 0 ))
+    return -1;
+
+  tr->eof = 0;
+  tr->cur = tr->end = tr->buf;
+  trace_fill( tr );
+
+  if ( tr->binary )
+    tr->cur += sizeof(trace_header_t);
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : trace_parse_line
+    Description : parse one "pid vaddr" text line
+    Inputs      : p - start of line
+                  eol - end of line
+                  pid - process id
+                  vaddr - address of access
+    Outputs     : 1 if parsed, 0 if blank, <0 if malformed
+
+***********************************************************************/
+
+static int trace_parse_line( const unsigned char *p, const unsigned char *eol,
+			     int *pid, vaddr_t *vaddr )
+{
+  vaddr_t v = 0;
+  int id = 0, digits = 0, d;
+
+  while ( p < eol && ( *p == ' ' || *p == '\t' || *p == '\r' )) p++;
+  if ( p == eol )
+    return 0;
+
+  for ( ; p < eol && *p >= '0' && *p <= '9'; p++, digits++ )
+    id = id * 10 + ( *p - '0' );
+  if ( !digits )
+    return -1;
+
+  while ( p < eol && ( *p == ' ' || *p == '\t' )) p++;
+  if (( eol - p > 1 ) && p[0] == '0' && ( p[1] == 'x' || p[1] == 'X' ))
+    p += 2;
+
+  for ( digits = 0; p < eol; p++, digits++ ) {
+    if ( *p >= '0' && *p <= '9' ) d = *p - '0';
+    else if ( *p >= 'a' && *p <= 'f' ) d = *p - 'a' + 10;
+    else if ( *p >= 'A' && *p <= 'F' ) d = *p - 'A' + 10;
+    else break;
+    v = ( v << 4 ) | d;
+  }
+  if (( !digits ) || ( digits > 16 ))
+    return -1;
+
+  *pid = id;
+  *vaddr = v;
+  return 1;
+}
+
+
+/**********************************************************************
+
+    Function    : trace_next
+    Description : get the next reference from the trace
+    Inputs      : tr - trace handle
+                  pid - process id
+                  vaddr - address of access
+                  op - read (0) or write (1)
+    Outputs     : 1 if a reference was read, 0 at end of trace, <0 if
+                  a text line is malformed (or fills the whole buffer)
+
+***********************************************************************/
+
+int trace_next( trace_t *tr, int *pid, vaddr_t *vaddr, int *op )
+{
+  const trace_rec_t *rec;
+  const unsigned char *eol;
+  int ret;
+
+  if ( tr->binary ) {
+    if (( tr->end - tr->cur < tr->recsize ) &&
+	( tr->map || tr->mem || ( trace_fill( tr ) < tr->recsize )))
+      return 0;
+
+    /* records are read in place from the mapped (or buffered) pages */
+    rec = (const trace_rec_t *)tr->cur;
+    tr->cur += tr->recsize;
+
+    *pid = rec->pid;
+    *vaddr = rec->vaddr;
+    *op = rec->op;
+    return 1;
+  }
+
+  while ( TRUE ) {
+    eol = memchr( tr->cur, '\n', tr->end - tr->cur );
+
+    if ( eol == NULL ) {
+      /* partial line: pull in more, unless this is the unterminated last line */
+      if ( !tr->eof ) {
+	if ( tr->end - tr->cur >= TRACE_BUFSIZE ) {
+	  fprintf( stderr, "trace: line longer than %d bytes\n", TRACE_BUFSIZE );
+	  return -1;
+	}
+	trace_fill( tr );
+	continue;
+      }
+      if ( tr->cur == tr->end )
+	return 0;
+      eol = tr->end;
+    }
+
+    ret = trace_parse_line( tr->cur, eol, pid, vaddr );
+    tr->cur = ( eol < tr->end ) ? eol + 1 : eol;
+
+    if ( ret > 0 )
+      break;
+    if ( ret < 0 ) {
+      fprintf( stderr, "trace: malformed reference\n" );
+      return -1;
+    }
+  }
+
+  *op = trace_text_op( *vaddr );
+  return 1;
+}
+
+
+/**********************************************************************
+
+    Function    : trace_close
+    Description : release the trace
+    Inputs      : tr - trace handle
+    Outputs     : 0 if successful, <0 otherwise
+
+***********************************************************************/
+
+int trace_close( trace_t *tr )
+{
+  if ( tr->map )
+    munmap( tr->map, tr->maplen );
+  free( tr->buf );
+
+  if (( tr->fd >= 0 ) && ( tr->fd != STDIN_FILENO ))
+    close( tr->fd );
+
+  free( tr );
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : trace_load
+    Description : decode a whole trace into memory, so it can be replayed
+                  many times (and by many threads) without parsing it again
+    Inputs      : tr - trace handle, at its first reference
+    Outputs     : in-memory trace if successful, NULL otherwise
+
+***********************************************************************/
+
+trace_t *trace_load( trace_t *tr )
+{
+  trace_t *mt;
+  trace_rec_t *recs, *more;
+  uint64_t n = 0, cap = tr->count ? tr->count : ( TRACE_BUFSIZE / sizeof(trace_rec_t) );
+  int pid, op, ret;
+  vaddr_t vaddr;
+
+  if (( mt = (trace_t *)calloc( 1, sizeof(trace_t) )) == NULL )
+    return NULL;
+
+  if (( recs = (trace_rec_t *)malloc( cap * sizeof(trace_rec_t) )) == NULL ) {
+    free( mt );
+    return NULL;
+  }
+
+  while (( ret = trace_next( tr, &pid, &vaddr, &op )) > 0 ) {
+    if ( n == cap ) {
+      cap *= 2;
+      if (( more = (trace_rec_t *)realloc( recs, cap * sizeof(trace_rec_t) )) == NULL ) {
+	free( recs );
+	free( mt );
+	return NULL;
+      }
+      recs = more;
+    }
+    recs[n].vaddr = vaddr;
+    recs[n].pid = pid;
+    recs[n].op = op;
+    n++;
+  }
+
+  /* a malformed line ends the load, not just the trace */
+  if ( ret < 0 ) {
+    free( recs );
+    free( mt );
+    return NULL;
+  }
+
+  mt->fd = -1;
+  mt->binary = 1;
+  mt->seekable = 1;
+  mt->mem = 1;
+  mt->recsize = sizeof(trace_rec_t);
+  mt->count = n;
+  mt->buf = (unsigned char *)recs;
+  mt->start = mt->cur = mt->buf;
+  mt->end = mt->start + n * sizeof(trace_rec_t);
+
+  return mt;
+}
+
+
+/**********************************************************************
+
+    Function    : trace_view
+    Description : open another cursor over the records of a mapped or
+                  in-memory trace.  The records stay with tr, which must
+                  outlive the view
+    Inputs      : tr - mapped or in-memory trace
+    Outputs     : trace handle if successful, NULL otherwise
+
+***********************************************************************/
+
+trace_t *trace_view( trace_t *tr )
+{
+  trace_t *vt;
+
+  assert( tr->map || tr->mem );
+
+  if (( vt = (trace_t *)malloc( sizeof(trace_t) )) == NULL )
+    return NULL;
+
+  /* views read from anywhere in the mapping, not front to back */
+  if ( tr->map )
+    madvise( tr->map, tr->maplen, MADV_NORMAL );
+
+  *vt = *tr;
+  vt->fd = -1;
+  vt->map = NULL;
+  vt->buf = NULL;
+  vt->mem = 1;
+  vt->cur = vt->start;
+
+  return vt;
+}
+
+
+/**********************************************************************
+
+    Function    : trace_create
+    Description : create a binary trace file for writing, noting the
+                  page size its ops are derived at
+    Inputs      : path - trace file name
+                  flags - TRACE_HAS_TIME if records carry a timestamp
+    Outputs     : file pointer if successful, NULL otherwise
+
+***********************************************************************/
+
+FILE *trace_create( char *path, unsigned int flags )
+{
+  FILE *fp;
+  trace_header_t hdr;
+
+  if (( fp = fopen( path, "w+" )) == NULL )
+    return NULL;
+
+  /* header is rewritten with the record count by trace_finish */
+  memset( &hdr, 0, sizeof(hdr) );
+  hdr.magic = TRACE_MAGIC;
+  hdr.version = TRACE_VERSION;
+  hdr.flags = flags;
+  hdr.recsize = sizeof(trace_rec_t) + (( flags & TRACE_HAS_TIME ) ? sizeof(uint64_t) : 0 );
+  hdr.page_size = page_size;    /* the ops are derived with trace_text_op */
+
+  if ( fwrite( &hdr, sizeof(hdr), 1, fp ) != 1 ) {
+    fclose( fp );
+    return NULL;
+  }
+
+  return fp;
+}
+
+
+/**********************************************************************
+
+    Function    : trace_append
+    Description : append one reference to a binary trace
+    Inputs      : fp - trace file from trace_create
+                  flags - flags given to trace_create
+                  pid - process id
+                  vaddr - address of access
+                  op - read (0) or write (1)
+                  time - timestamp (ignored unless TRACE_HAS_TIME)
+    Outputs     : 0 if successful, <0 otherwise
+
+***********************************************************************/
+
+int trace_append( FILE *fp, unsigned int flags, int pid, uint64_t vaddr, int op, uint64_t time )
+{
+  trace_rec_t rec;
+
+  rec.vaddr = vaddr;
+  rec.pid = pid;
+  rec.op = op;
+
+  if ( fwrite( &rec, sizeof(rec), 1, fp ) != 1 )
+    return -1;
+
+  if (( flags & TRACE_HAS_TIME ) && ( fwrite( &time, sizeof(time), 1, fp ) != 1 ))
+    return -1;
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : trace_finish
+    Description : record the final count in the header and close the trace
+    Inputs      : fp - trace file from trace_create
+                  count - number of records written
+    Outputs     : 0 if successful, <0 otherwise
+
+***********************************************************************/
+
+int trace_finish( FILE *fp, uint64_t count )
+{
+  trace_header_t hdr;
+  int err = 0;
+
+  if (( fseek( fp, 0, SEEK_SET ) != 0 ) ||
+      ( fread( &hdr, sizeof(hdr), 1, fp ) != 1 ))
+    err = -1;
+
+  if ( !err ) {
+    hdr.count = count;
+    if (( fseek( fp, 0, SEEK_SET ) != 0 ) ||
+	( fwrite( &hdr, sizeof(hdr), 1, fp ) != 1 ))
+      err = -1;
+  }
+
+  if ( fclose( fp ) != 0 )
+    err = -1;
+
+  return err;
+}
@@ -0,0 +1,599 @@
+/**********************************************************************
+
+   File          : cmsc312-p2-ws.c
+
+   Description   : Working sets and load control.  The working set of a
+                   process is the set of pages touched by its last
+                   ws_window references, counted in its own references.
+                   A ring holds the directory entry of each of those
+                   references and each entry the time of its page's last
+                   reference, so a reference adds its page and retires
+                   the one that slid out of the window in O(1).
+
+                   Load control looks every ws_window references.  With
+                   working sets, it suspends processes while the working
+                   sets of those running exceed the frames, and resumes
+                   the longest suspended once its working set fits; with
+                   page-fault frequency, it suspends one when more than
+                   pff_high percent of references fault and resumes one
+                   under pff_low.  A suspended process is swapped out
+                   and its references are held, in order, until it runs
+                   again -- or until WS_HELD_MAX are held, when it is
+                   resumed whether it fits or not.  Load control keeps
+                   each process's resident frames on a list, and lists
+                   of the processes running and suspended, so a check
+                   costs what those processes hold, not the machine
+                   (see .h for applications)
+
+***********************************************************************/
+/**********************************************************************
+Copyright (c) 2016 The Pennsylvania State University
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+    * Neither the name of The Pennsylvania State University nor the names of its contributors may be used to endorse or promote products derived from this softwiare without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* Include Files */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <assert.h>
+
+/* Project Include Files */
+#include "cmsc312-p2.h"
+
+/* Definitions */
+#define WS_HELD_MIN   64            /* held references, first allocation */
+#define WS_HELD_MAX   ( 1 << 16 )   /* ... and most before a forced resume */
+
+
+/**********************************************************************
+
+    Function    : ws_init
+    Description : start tracking working sets on the current machine;
+                  each process's window is allocated on its first
+                  reference
+    Inputs      : none
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int ws_init( void )
+{
+  int i;
+
+  if (( sim->ws = (wset_t *)calloc( max_processes, sizeof(wset_t) )) == NULL )
+    return -1;
+  if ( !load_control )
+    return 0;
+
+  if ( qlist_init( &sim->ws_frames, sim->frames ) ||
+       qlist_init( &sim->ws_active, max_processes ) ||
+       qlist_init( &sim->ws_suspended, max_processes ))
+    return -1;
+
+  /* a frame is resident for one process at most, so the processes'
+     lists share one set of links */
+  for ( i = 0; i < max_processes; i++ )
+    qlist_share( &sim->ws[i].resident, &sim->ws_frames );
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : ws_exit
+    Description : free the working sets and any held references
+    Inputs      : none
+    Outputs     : none
+
+***********************************************************************/
+
+void ws_exit( void )
+{
+  int i;
+
+  if ( sim->ws == NULL )
+    return;
+
+  for ( i = 0; i < max_processes; i++ ) {
+    if ( sim->ws[i].ring ) {
+      qdir_free( &sim->ws[i].dir );
+      free( sim->ws[i].ring );
+      free( sim->ws[i].last );
+    }
+    free( sim->ws[i].held );
+  }
+
+  if ( load_control ) {
+    qlist_free( &sim->ws_frames );
+    qlist_free( &sim->ws_active );
+    qlist_free( &sim->ws_suspended );
+  }
+  free( sim->ws );
+  sim->ws = NULL;
+}
+
+
+/**********************************************************************
+
+    Function    : ws_ref
+    Description : slide a process's window over its latest reference
+                  (the process's ct is the time of the reference)
+    Inputs      : pid - process id
+                  page - page referenced
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int ws_ref( int pid, vpn_t page )
+{
+  wset_t *w = &sim->ws[pid];
+  uint64_t t = sim->processes[pid].ct;
+  int slot = t % ws_window;
+  int e;
+
+  if ( w->ring == NULL ) {
+    w->ring = (int *)malloc( sizeof(int) * ws_window );
+    w->last = (uint64_t *)malloc( sizeof(uint64_t) * ws_window );
+    if (( w->ring == NULL ) || ( w->last == NULL ) || qdir_init( &w->dir, ws_window ))
+      return -1;
+  }
+
+  /* the reference at t - ws_window leaves the window, and its page too
+     unless the page was referenced since */
+  if ( t > ws_window ) {
+    e = w->ring[slot];
+    if ( w->last[e] == t - ws_window ) {
+      qdir_del( &w->dir, e );
+      w->size--;
+    }
+  }
+
+  /* at most ws_window - 1 pages are left, so there is an entry free */
+  if (( e = qdir_find( &w->dir, pid, page )) == QLIST_NONE ) {
+    e = qdir_add( &w->dir, pid, page );
+    w->size++;
+  }
+
+  w->last[e] = t;
+  w->ring[slot] = e;
+
+  w->sum += w->size;
+  if ( w->size > w->peak )
+    w->peak = w->size;
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : ws_run
+    Description : run a reference now, counting its fault against the
+                  process
+    Inputs      : pid - process id
+                  vaddr - virtual address
+                  op - read (0) or write (1)
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+static int ws_run( int pid, vaddr_t vaddr, int op )
+{
+  wset_t *w = &sim->ws[pid];
+  uint64_t pfs = sim->pfs;
+
+  if ( sim_step( pid, vaddr, op ))
+    return -1;
+
+  w->seen = sim->ws_clock;
+  if ( load_control && !qlist_on( &sim->ws_active, pid ))
+    qlist_append( &sim->ws_active, pid );
+  sim->ws_refs++;
+  if ( sim->pfs != pfs ) {
+    w->pfs++;
+    w->faults++;
+    sim->ws_faults++;
+  }
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : ws_hold
+    Description : hold a reference of a suspended process
+    Inputs      : w - the process's working set
+                  vaddr - virtual address
+                  op - read (0) or write (1)
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+static int ws_hold( wset_t *w, vaddr_t vaddr, int op )
+{
+  ws_ref_t *held;
+  int n;
+
+  if ( w->nheld == w->maxheld ) {
+    n = w->maxheld ? 2 * w->maxheld : WS_HELD_MIN;
+    if (( held = (ws_ref_t *)realloc( w->held, sizeof(ws_ref_t) * n )) == NULL )
+      return -1;
+    w->held = held;
+    w->maxheld = n;
+  }
+
+  w->held[w->nheld].vaddr = vaddr;
+  w->held[w->nheld].op = op;
+  w->nheld++;
+  sim->ws_held++;
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : ws_suspend
+    Description : suspend a process and swap it out
+    Inputs      : pid - process id
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+static int ws_suspend( int pid )
+{
+  wset_t *w = &sim->ws[pid];
+  int at, n = 0;
+
+  /* each page swapped out takes its frame off the list */
+  while ( w->resident.head != QLIST_NONE ) {
+    if ( pt_swap_out( pid, &sim->physical_mem[w->resident.head] ))
+      return -1;
+    n++;
+  }
+
+  /* longest suspended first, those of one check in pid order */
+  for ( at = sim->ws_suspended.tail;
+	( at != QLIST_NONE ) && ( sim->ws[at].since == sim->ws_clock ) && ( at > pid );
+	at = sim->ws_suspended.prev[at] )
+    ;
+  if ( qlist_on( &sim->ws_active, pid ))
+    qlist_remove( &sim->ws_active, pid );
+  qlist_insert( &sim->ws_suspended, pid, at );
+  w->suspended = 1;
+  w->faults = 0;
+  w->since = sim->ws_clock;
+  w->suspensions++;
+  sim->ws_suspensions++;
+  sim->ws_swapped += n;
+
+  EVENT( LOG_FAULTS, EV_SUSPEND, pid, 0, -1, n );
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : ws_resume
+    Description : resume a process: it runs the references it was held
+                  back from, in order (faulting its pages back in)
+    Inputs      : pid - process id
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+static int ws_resume( int pid )
+{
+  wset_t *w = &sim->ws[pid];
+  int i, n = w->nheld;
+
+  EVENT( LOG_FAULTS, EV_RESUME, pid, 0, -1, n );
+
+  qlist_remove( &sim->ws_suspended, pid );
+  qlist_append( &sim->ws_active, pid );
+  w->suspended = 0;
+  w->nheld = 0;
+
+  for ( i = 0; i < n; i++ ) {
+    if ( ws_run( pid, w->held[i].vaddr, w->held[i].op ))
+      return -1;
+  }
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : ws_running
+    Description : is a process running: not suspended, and it ran in the
+                  last window (a process done with the trace is not)
+    Inputs      : w - the process's working set
+    Outputs     : 1 if running, 0 if not
+
+***********************************************************************/
+
+static int ws_running( wset_t *w )
+{
+  return w->ring && !w->suspended && ( sim->ws_clock - w->seen <= (uint64_t)ws_window );
+}
+
+
+/**********************************************************************
+
+    Function    : ws_victim
+    Description : the running process to suspend: the largest working
+                  set (it frees the most frames), or under page-fault
+                  frequency the most faults since the last check; the
+                  lowest pid among equals
+    Inputs      : none
+    Outputs     : process id, or -1 if none is running
+
+***********************************************************************/
+
+static int ws_victim( void )
+{
+  wset_t *w, *v = NULL;
+  int i, pid = -1;
+
+  for ( i = sim->ws_active.head; i != QLIST_NONE; i = sim->ws_active.next[i] ) {
+    w = &sim->ws[i];
+    if ( !ws_running( w ))
+      continue;
+    if (( v == NULL ) ||
+	(( load_control == LOAD_PFF ) && ( w->faults > v->faults )) ||
+	((( load_control == LOAD_WS ) || ( w->faults == v->faults )) && ( w->size > v->size )) ||
+	((( load_control == LOAD_WS ) || ( w->faults == v->faults )) && ( w->size == v->size ) &&
+	 ( i < pid ))) {
+      v = w;
+      pid = i;
+    }
+  }
+
+  return pid;
+}
+
+
+/**********************************************************************
+
+    Function    : ws_check
+    Description : load control: suspend processes while memory is
+                  overcommitted, else resume the longest suspended while
+                  there is room (or if nothing else is running)
+    Inputs      : none
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+static int ws_check( void )
+{
+  int demand = 0, running = 0;
+  int i, next, pid, over, room;
+
+  /* a process that has stopped running leaves the list until it runs
+     again */
+  for ( i = sim->ws_active.head; i != QLIST_NONE; i = next ) {
+    next = sim->ws_active.next[i];
+    if ( ws_running( &sim->ws[i] )) {
+      demand += sim->ws[i].size;
+      running++;
+    }
+    else
+      qlist_remove( &sim->ws_active, i );
+  }
+
+  if ( demand > sim->ws_peak_demand )
+    sim->ws_peak_demand = demand;
+
+  if ( load_control == LOAD_WS )
+    over = ( demand > sim->frames );
+  else
+    over = ( sim->ws_faults * 100 > pff_high * sim->ws_refs );
+
+  if ( over ) {
+    sim->ws_overloads++;
+
+    /* the last one running keeps running, thrashing or not; a fault
+       rate only shows what a suspension did after the next window */
+    while ( over && ( running > 1 )) {
+      pid = ws_victim( );
+      demand -= sim->ws[pid].size;
+      running--;
+      if ( ws_suspend( pid ))
+	return -1;
+      over = ( load_control == LOAD_WS ) && ( demand > sim->frames );
+    }
+  }
+  else {
+    while (( pid = sim->ws_suspended.head ) != QLIST_NONE ) {
+      if ( load_control == LOAD_WS )
+	room = ( demand + sim->ws[pid].size <= sim->frames );
+      else
+	room = ( sim->ws_faults * 100 < pff_low * sim->ws_refs );
+      if ( !room && running )
+	break;
+
+      demand += sim->ws[pid].size;
+      running++;
+      if ( ws_resume( pid ))
+	return -1;
+      if ( load_control == LOAD_PFF )
+	break;
+    }
+  }
+
+  /* only a process that ran has faults to clear (ws_suspend clears
+     those of one suspended) */
+  for ( i = sim->ws_active.head; i != QLIST_NONE; i = sim->ws_active.next[i] )
+    sim->ws[i].faults = 0;
+  sim->ws_refs = 0;
+  sim->ws_faults = 0;
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : ws_access
+    Description : a reference arrives: run it, or hold it if its process
+                  is suspended; load control looks every window
+    Inputs      : pid - process id
+                  vaddr - virtual address
+                  op - read (0) or write (1)
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int ws_access( int pid, vaddr_t vaddr, int op )
+{
+  wset_t *w = &sim->ws[pid];
+
+  sim->ws_clock++;
+
+  if ( w->suspended ? ws_hold( w, vaddr, op ) : ws_run( pid, vaddr, op ))
+    return -1;
+
+  /* a process cannot be held back without bound: once its hold is full
+     it runs again, and the next check may suspend it again */
+  if ( w->suspended && ( w->nheld == WS_HELD_MAX )) {
+    sim->ws_full++;
+    if ( ws_resume( pid ))
+      return -1;
+  }
+
+  if ( load_control && (( sim->ws_clock % ws_window ) == 0 ))
+    return ws_check( );
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : ws_finish
+    Description : the trace is done: resume every suspended process, the
+                  longest suspended first
+    Inputs      : none
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int ws_finish( void )
+{
+  int pid;
+
+  if ( !load_control )
+    return 0;
+
+  while (( pid = sim->ws_suspended.head ) != QLIST_NONE ) {
+    if ( ws_resume( pid ))
+      return -1;
+  }
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : ws_frame_taken
+    Description : a frame was given to a process (load control)
+    Inputs      : f - frame, already holding the process's pid
+    Outputs     : none
+
+***********************************************************************/
+
+void ws_frame_taken( frame_t *f )
+{
+  qlist_append( &sim->ws[f->pid].resident, f->number );
+}
+
+
+/**********************************************************************
+
+    Function    : ws_frame_freed
+    Description : a process's frame was freed (load control)
+    Inputs      : f - frame, still holding the process's pid
+    Outputs     : none
+
+***********************************************************************/
+
+void ws_frame_freed( frame_t *f )
+{
+  qlist_remove( &sim->ws[f->pid].resident, f->number );
+}
+
+
+/**********************************************************************
+
+    Function    : ws_write
+    Description : write each process's working set and what load
+                  control did
+    Inputs      : out - file pointer of output file
+    Outputs     : none
+
+***********************************************************************/
+
+void ws_write( FILE *out )
+{
+  static const char *modes[] = { "off", "working sets", "page-fault frequency" };
+  wset_t *w;
+  int i;
+
+  fprintf( out, "++++++++++++++++++++ Working Sets ++++++++++++++++++\n" );
+  fprintf( out, "window: last %d references of each process; load control: %s",
+	   ws_window, modes[load_control] );
+  if ( load_control == LOAD_PFF )
+    fprintf( out, " (suspend over %d%% faulting, resume under %d%%)", pff_high, pff_low );
+  fprintf( out, "\n" );
+
+  for ( i = 0; i < max_processes; i++ ) {
+    w = &sim->ws[i];
+    if ( w->ring == NULL )
+      continue;
+    fprintf( out, "pid %d: %llu references; working set mean %.2f, peak %d pages; %llu faults",
+	     i, (unsigned long long)sim->processes[i].ct, (double)w->sum / sim->processes[i].ct,
+	     w->peak, (unsigned long long)w->pfs );
+    if ( load_control )
+      fprintf( out, "; suspended %d times", w->suspensions );
+    fprintf( out, "\n" );
+  }
+
+  if ( load_control ) {
+    fprintf( out, "peak demand: %d pages for %d frames; checks finding memory overcommitted: %llu\n",
+	     sim->ws_peak_demand, sim->frames, (unsigned long long)sim->ws_overloads );
+    fprintf( out, "suspensions: %llu (%llu pages swapped out); references held back: %llu\n",
+	     (unsigned long long)sim->ws_suspensions, (unsigned long long)sim->ws_swapped,
+	     (unsigned long long)sim->ws_held );
+    if ( sim->ws_full )
+      fprintf( out, "resumed early, their hold full (%d references): %llu\n",
+	       WS_HELD_MAX, (unsigned long long)sim->ws_full );
+  }
+}
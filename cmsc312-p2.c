@@ -38,6 +38,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <unistd.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <sys/types.h>
@@ -50,44 +51,138 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "cmsc312-p2.h"
 
 /* Definitions */
-#define USAGE "cmsc312-p2 <input.file> <output.file> <replacement.mech>"
+#define USAGE "cmsc312-p2 [options] <input.file|-> <output.file> <replacement.mech>[,mech...]|all\n" \
+              "  -c file       read \"key = value\" settings (options are applied in order)\n" \
+              "  -f frames     physical frames\n" \
+              "  -t entries    TLB entries\n" \
+              "  -a ways       TLB associativity: 0 fully associative, 1 direct-mapped, N-way\n" \
+              "  -A asids      tag TLB entries with this many ASIDs instead of flushing on switch\n" \
+              "                (an untagged TLB runs alongside, for comparison)\n" \
+              "  -b bits       virtual address bits per process (up to 64)\n" \
+              "  -L levels     radix page table levels (1-4)\n" \
+              "  -H            promote dense regions to huge pages\n" \
+              "  -i            one inverted (hashed) page table instead of per-process tables\n" \
+              "  -s bytes      page size (a power of two)\n" \
+              "  -n procs      maximum number of processes (pids 0..procs-1)\n" \
+              "  -v level      event logging: 0 off, 1 faults only, 2 every access\n" \
+              "  -l event.log  binary event log (default " EVENT_FILE "; see cmsc312-p2-conv -d)\n" \
+              "  -F frames     sweep frame counts: a list (4,8,16) or doubling range (4-64)\n" \
+              "  -T entries    sweep TLB sizes, as for -F; a sweep writes a CSV grid\n" \
+              "  -j threads    sweep threads (default one per CPU)\n" \
+              "  -M            write the LRU page-fault curve for every frame count instead\n" \
+              "  -w refs       track working sets over each process's last refs references\n" \
+              "  -W mode       load control, suspending processes: 1 working sets, 2 page-fault\n" \
+              "                frequency (see pff_high/pff_low; window default 1000)\n" \
+              "  -q mode       local replacement within per-process frame quotas: 1 equal,\n" \
+              "                2 proportional to working sets, 3 adapted to page-fault frequency\n" \
+              "  -D frames     page cleaner: write dirty pages back once fewer frames are free or clean\n" \
+              "  -B pages      pages the cleaner writes back together (default 16)\n" \
+              "  -S path       swap to real files (path.0, path.1, ... one per machine, removed\n" \
+              "                at exit), evicted pages written swap_batch (16) at a time\n" \
+              "  -R pages      read ahead along sequential or strided fault streams, up to\n" \
+              "                pages a fault (results compare with the machine without)\n"
+#define EVENT_FILE "cmsc312-p2.events"
 #define NUM_PROCESSES 30
 
-/* need a store for all processes */
-task_t processes[MAX_PROCESSES];
-
-/* physical memory representation */
-frame_t physical_mem[PHYSICAL_FRAMES];
-
-/* tlb */
-tlb_t tlb[TLB_ENTRIES];
-
-/* current pagetable */
-ptentry_t *current_pt;
-int current_pid = 0;
-
-/* overall stats */
-int swaps = 0;             /* swaps to disk */
-int invalidates = 0;       /* reassign page w/o swap */
-int pfs = 0;               /* all page faults */
-int memory_accesses = 0;   /* accesses that miss TLB but hit memory */
-int total_accesses = 0;    /* all accesses */
+/* the simulated machine run by this thread -- see sim_create */
+__thread sim_t *sim;
 
 /* page replacement algorithms */
-int (*pt_replace_init[])( FILE *fp ) = { init_mfu
+int (*pt_replace_init[])( trace_t *tr ) = { init_mfu
 					 , init_second
 					 , init_lfu
+					 , init_opt
+					 , init_lru
+					 , init_arc
+					 , init_car
+					 , init_2q
+					 , init_lirs
 };
 
 int (*pt_choose_victim[])( int *pid, frame_t **victim ) = { replace_mfu 
 							    , replace_second 
 							    , replace_lfu
+							    , replace_opt
+							    , replace_lru
+							    , replace_arc
+							    , replace_car
+							    , replace_2q
+							    , replace_lirs
+};
+
+/* page replacement -- a resident page was referenced (its ct bumped) */
+int (*pt_ref_replacement[])( int pid, frame_t *f ) = { ref_mfu
+						       , ref_second
+						       , ref_lfu
+						       , ref_opt
+						       , ref_lru
+						       , ref_arc
+						       , ref_car
+						       , ref_2q
+						       , ref_lirs
+};
+
+/* page replacement -- does init read ahead in the trace (e.g., optimal)? */
+int pt_replace_lookahead[] = { 0     /* mfu */
+			       , 0   /* second */
+			       , 0   /* lfu */
+			       , 1   /* opt */
+			       , 0   /* lru */
+			       , 0   /* arc */
+			       , 0   /* car */
+			       , 0   /* 2q */
+			       , 0   /* lirs */
+};
+
+/* page replacement -- free the mechanism's state */
+void (*pt_replace_exit[])( void ) = { exit_mfu
+				      , exit_second
+				      , exit_lfu
+				      , exit_opt
+				      , exit_lru
+				      , exit_arc
+				      , exit_car
+				      , exit_2q
+				      , exit_lirs
 };
 
 /* page replacement -- update state at allocation time */
 int (*pt_update_replacement[])( int pid, frame_t *f ) = { update_mfu 
 							  , update_second
 							  , update_lfu
+							  , update_opt
+							  , update_lru
+							  , update_arc
+							  , update_car
+							  , update_2q
+							  , update_lirs
+};
+
+#define NUM_MECHS  (int)( sizeof(pt_replace_init) / sizeof(pt_replace_init[0]) )
+
+/* page replacement -- a frame is freed outside of replacement (its
+   process was swapped out): forget it */
+int (*pt_release_replacement[])( int pid, frame_t *f ) = { release_mfu
+							   , release_second
+							   , release_lfu
+							   , release_opt
+							   , release_lru
+							   , release_arc
+							   , release_car
+							   , release_2q
+							   , release_lirs
+};
+
+/* page replacement -- names for the results */
+char *pt_mech_names[] = { "mfu"
+			  , "second"
+			  , "lfu"
+			  , "opt"
+			  , "lru"
+			  , "arc"
+			  , "car"
+			  , "2q"
+			  , "lirs"
 };
 
 /**********************************************************************
@@ -104,11 +199,120 @@ int (*pt_update_replacement[])( int pid, frame_t *f ) = { update_mfu
 int main( int argc, char **argv ) 
 {
     int eof = 0;
-    FILE *in, *out;
+    trace_t *in;
+    FILE *out;
     int op;  /* read (0) or write (1) */
+    int mechs[NUM_MECHS];
+    sim_t *sims[NUM_MECHS];
+    int nsims = 0;
+    int i, c;
+    char *list, *next;
+    char *sweep_frames = NULL, *sweep_entries = NULL;
+    int *frames = NULL, *entries = NULL;
+    int nframes = 1, nentries = 1, threads = 0;
+    int curve = 0;
+    int level = LOG_OFF;
+    char *event_file = EVENT_FILE;
+
+    while (( c = getopt( argc, argv, "c:f:t:a:A:b:L:His:n:v:l:F:T:j:Mw:W:q:D:B:S:R:" )) != -1 ) {
+      switch ( c ) {
+      case 'c':
+        if ( config_load( optarg ))
+          exit( -1 );
+        break;
+      case 'f':
+        if ( config_set( "physical_frames", optarg ))
+          exit( -1 );
+        break;
+      case 't':
+        if ( config_set( "tlb_entries", optarg ))
+          exit( -1 );
+        break;
+      case 'a':
+        if ( config_set( "tlb_ways", optarg ))
+          exit( -1 );
+        break;
+      case 'A':
+        if ( config_set( "tlb_asids", optarg ) || config_set( "tlb_tagged", "1" ))
+          exit( -1 );
+        break;
+      case 'b':
+        if ( config_set( "va_bits", optarg ))
+          exit( -1 );
+        break;
+      case 'L':
+        if ( config_set( "pt_levels", optarg ))
+          exit( -1 );
+        break;
+      case 'H':
+        if ( config_set( "huge_pages", "1" ))
+          exit( -1 );
+        break;
+      case 'i':
+        if ( config_set( "pt_mode", "1" ))
+          exit( -1 );
+        break;
+      case 's':
+        if ( config_set( "page_size", optarg ))
+          exit( -1 );
+        break;
+      case 'n':
+        if ( config_set( "max_processes", optarg ))
+          exit( -1 );
+        break;
+      case 'v':
+        level = atoi( optarg );
+        break;
+      case 'l':
+        event_file = optarg;
+        break;
+      case 'F':
+        sweep_frames = optarg;
+        break;
+      case 'T':
+        sweep_entries = optarg;
+        break;
+      case 'j':
+        threads = atoi( optarg );
+        break;
+      case 'M':
+        curve = 1;
+        break;
+      case 'w':
+        if ( config_set( "ws_window", optarg ))
+          exit( -1 );
+        break;
+      case 'W':
+        if ( config_set( "load_control", optarg ))
+          exit( -1 );
+        break;
+      case 'q':
+        if ( config_set( "local_quota", optarg ))
+          exit( -1 );
+        break;
+      case 'D':
+        if ( config_set( "clean_low", optarg ))
+          exit( -1 );
+        break;
+      case 'B':
+        if ( config_set( "clean_batch", optarg ))
+          exit( -1 );
+        break;
+      case 'S':
+        swap_path = optarg;
+        break;
+      case 'R':
+        if ( config_set( "readahead", optarg ))
+          exit( -1 );
+        break;
+      default:
+        fprintf( stderr, USAGE );
+        exit( -1 );
+      }
+    }
 
     /* Check for arguments */
-    if ( argc < 4 ) 
+    if ( argc - optind < 3 ) 
     {
         /* Complain, explain, and exit */
         fprintf( stderr, "missing or bad command line arguments\n" );
@@ -116,23 +320,138 @@ int main( int argc, char **argv )
         exit( -1 );
     }
 
+    if ( config_check( ))
+      exit( -1 );
+
+    /* a sweep runs the sizes given, or else the configured size */
+    if ( sweep_frames || sweep_entries ) {
+      if (( sweep_frames && (( nframes = sweep_list( sweep_frames, &frames )) < 0 )) ||
+	  ( sweep_entries && (( nentries = sweep_list( sweep_entries, &entries )) < 0 )))
+	exit( -1 );
+      if ( sweep_frames == NULL )
+	frames = &physical_frames;
+      if ( sweep_entries == NULL )
+	entries = &tlb_entries;
+
+      for ( i = 0; i < nframes; i++ ) {
+	if ( huge_pages && (( 1 << huge_order ) > frames[i] )) {
+	  fprintf( stderr, "sweep: huge pages need at least %d frames\n", 1 << huge_order );
+	  exit( -1 );
+	}
+      }
+      for ( i = 0; i < nentries; i++ ) {
+	int ways;
+	unsigned int set_mask;
+
+	if ( config_tlb( entries[i], &ways, &set_mask ))
+	  exit( -1 );
+      }
 
-    /* open the input file and return the file descriptor */
-    if (( in = fopen( argv[1], "r" )) < 0 ) {
+      /* the event log is one stream, not one per thread */
+      if ( level > LOG_OFF ) {
+	fprintf( stderr, "sweep: no event logging (-v) in a sweep\n" );
+	exit( -1 );
+      }
+    }
+
+    /* open the input trace (text or binary) */
+    if (( in = trace_open( argv[optind] )) == NULL ) {
       fprintf( stderr, "input file open failure\n" );
       return -1;
     }
 
+    if ( event_open( event_file, level )) {
+      fprintf( stderr, "event log open failure\n" );
+      return -1;
+    }
+
     /* Initialization */
     /* for example: build optimal list */
-    page_replacement_init( in, atoi(argv[3]) );
+    /* several mechanisms each get their own machine, fed the same trace */
+    list = argv[optind+2];
+    if ( strcmp( list, "all" ) == 0 ) {
+      for ( nsims = 0; nsims < NUM_MECHS; nsims++ )
+	mechs[nsims] = nsims;
+    }
+    else {
+      do {
+	mechs[nsims] = (int)strtol( list, &next, 10 );
+	if (( next == list ) || (( *next != ',' ) && ( *next != '\0' )) ||
+	    ( mechs[nsims] < 0 ) || ( mechs[nsims] >= NUM_MECHS )) {
+	  fprintf( stderr, "bad replacement mechanism %s\n", list );
+	  exit( -1 );
+	}
+	for ( i = 0; i < nsims; i++ ) {
+	  if ( mechs[i] == mechs[nsims] ) {
+	    fprintf( stderr, "replacement mechanism %d given twice\n", mechs[i] );
+	    exit( -1 );
+	  }
+	}
+	nsims++;
+	list = next + 1;
+      } while (( *next == ',' ) && ( nsims < NUM_MECHS ));
+      if ( *next == ',' ) {
+	fprintf( stderr, "too many replacement mechanisms\n" );
+	exit( -1 );
+      }
+    }
+
+    /* held references run out of trace order, which lookahead cannot follow */
+    for ( i = 0; i < nsims; i++ ) {
+      if ( load_control && pt_replace_lookahead[mechs[i]] ) {
+	fprintf( stderr, "load control reorders references; %s needs them in trace order\n",
+		 pt_mech_names[mechs[i]] );
+	exit( -1 );
+      }
+    }
+
+    /* one pass gives the faults for every frame count */
+    if ( curve ) {
+      if (( out = fopen( argv[optind+1], "w+" )) == NULL ) {
+	fprintf( stderr, "write output info\n" );
+	return -1;
+      }
+      if ( stack_curve( in, out ))
+	exit( -1 );
+      fclose( out );
+      trace_close( in );
+      exit( 0 );
+    }
+
+    if ( frames ) {
+      if (( out = fopen( argv[optind+1], "w+" )) == NULL ) {
+	fprintf( stderr, "write output info\n" );
+	return -1;
+      }
+      if ( sweep_run( in, mechs, nsims, frames, nframes, entries, nentries, threads, out ))
+	exit( -1 );
+      fclose( out );
+      trace_close( in );
+      exit( 0 );
+    }
+
+    for ( i = 0; i < nsims; i++ ) {
+      if (( sims[i] = sim_create( in, mechs[i], physical_frames, tlb_entries )) == NULL ) {
+	fprintf( stderr, "page_replacement_init\n" );
+	exit( -1 );
+      }
+
+      /* readahead is measured against the same machine reading on
+	 demand only (not run when logging, which is one stream) */
+      if ( readahead_max && ( level == LOG_OFF )) {
+	if (( sims[i]->ra_base = sim_create( in, mechs[i], physical_frames, tlb_entries )) == NULL ) {
+	  fprintf( stderr, "page_replacement_init\n" );
+	  exit( -1 );
+	}
+	ra_exit( );
+      }
+    }
 
     
     /* execution loop */
     while ( TRUE ) {
       int pid; 
-      unsigned int vaddr, paddr;
-      int valid;
+      vaddr_t vaddr;
 
       /* get memory access */
       if ( get_memory_access( in, &pid, &vaddr, &op, &eof )) { // process one line of input
@@ -143,43 +462,265 @@ int main( int argc, char **argv )
       /* done at eof */
       if ( eof ) break;
 
-      total_accesses++;
-
-      /* if memory access count reaches window size, update working set bits */
-      processes[pid].ct++;
+      if (( pid < 0 ) || ( pid >= max_processes )) {
+        fprintf( stderr, "bad pid %d in trace\n", pid );
+        exit( -1 );
+      }
 
-      /* check if need to context switch */
-      if (( !current_pid ) || ( pid != current_pid )) {
-	       if ( context_switch( pid )) {
-	         fprintf( stderr, "context_switch\n" );
-	         exit( -1 );	
-	       }
+      /* radix page tables cover va_bits of address space */
+      if (( va_bits < 64 ) && ( vaddr >> va_bits )) {
+        fprintf( stderr, "bad vaddr 0x%llx in trace (beyond %d bits)\n",
+		 (unsigned long long)vaddr, va_bits );
+        exit( -1 );
       }
-      
-      /* lookup mapping in TLB */
-      if ( !tlb_resolve_addr( vaddr, &paddr, op )) {
-	       pt_resolve_addr( vaddr, &paddr, &valid, op );
 
-	       /* if invalid, update page tables (w/ replacement, if necessary) */
-	       if ( !valid )
-	         pt_demand_page( pid, vaddr, &paddr, op, atoi(argv[3]) );
+      /* the record is decoded once; every machine replays it */
+      for ( i = 0; i < nsims; i++ ) {
+	sim = sims[i];
+	if ( sim_access( pid, vaddr, op ))
+	  exit( -1 );
+	if (( sim = sims[i]->ra_base ) && sim_access( pid, vaddr, op ))
+	  exit( -1 );
       }
     }
     
+    /* run what load control still holds */
+    for ( i = 0; i < nsims; i++ ) {
+      sim = sims[i];
+      if ( sim_finish( ))
+	exit( -1 );
+      if (( sim = sims[i]->ra_base ) && sim_finish( ))
+	exit( -1 );
+    }
+
     /* close the input file */
-    fclose( in );	
+    trace_close( in );
+    event_close( );
     
     /* open the output file and return the file descriptor */
-    if (( out = fopen( argv[2], "w+" )) < 0 ) {
+    if (( out = fopen( argv[optind+1], "w+" )) == NULL ) {
 	     fprintf( stderr, "write output info\n" );
 	     return -1;
     }
       
-    write_results( out );
+    sim = sims[0];
+    if ( nsims == 1 )
+      write_results( out );
+    else
+      write_compare( out, sims, nsims );
 
     exit( 0 );
 }
 
+
+/**********************************************************************
+
+    Function    : sim_access
+    Description : Give the current machine (sim) the next memory access
+                  of the trace
+    Inputs      : pid - process id
+                  vaddr - virtual address
+                  op - read (0) or write (1)
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int sim_access( int pid, vaddr_t vaddr, int op )
+{
+  /* with working sets tracked, load control decides when it runs */
+  if ( sim->ws )
+    return ws_access( pid, vaddr, op );
+
+  return sim_step( pid, vaddr, op );
+}
+
+
+/**********************************************************************
+
+    Function    : sim_step
+    Description : Run one memory access on the current machine (sim)
+    Inputs      : pid - process id
+                  vaddr - virtual address
+                  op - read (0) or write (1)
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int sim_step( int pid, vaddr_t vaddr, int op )
+{
+  uint64_t paddr;
+  int valid;
+
+  /* every event of the access carries its number */
+  sim->total_accesses++;
+  EVENT( LOG_FULL, EV_ACCESS, pid, vaddr, -1, op );
+
+  /* check if need to context switch (creates the process on first use) */
+  if ( pid != sim->current_pid ) {
+    if ( context_switch( pid )) {
+      fprintf( stderr, "context_switch\n" );
+      return -1;
+    }
+  }
+
+  /* the process's own reference count is the clock its working set
+     window slides along */
+  sim->processes[pid].ct++;
+  if ( sim->ws && ws_ref( pid, vaddr >> page_shift ))
+    return -1;
+
+  /* changing quotas are revisited once a window */
+  if (( local_quota >= LOCAL_PROP ) && (( sim->total_accesses % ws_window ) == 0 ))
+    local_adjust( );
+
+  /* lookup mapping in TLB */
+  if ( !tlb_resolve_addr( vaddr, &paddr, op )) {
+    pt_resolve_addr( vaddr, &paddr, &valid, op );
+
+    /* if invalid, update page tables (w/ replacement, if necessary) */
+    if ( !valid && pt_demand_page( pid, vaddr, &paddr, op, sim->mech )) {
+      fprintf( stderr, "pt_demand_page\n" );
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+/**********************************************************************
+
+    Function    : sim_finish
+    Description : Run the accesses the current machine still holds at
+                  the end of the trace
+    Inputs      : none
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int sim_finish( void )
+{
+  if ( sim->ws && ws_finish( ))
+    return -1;
+
+  /* evicted pages still waiting are written */
+  return sim->swap ? swap_flush( ) : 0;
+}
+
+
+/**********************************************************************
+
+    Function    : tlb_write_mode
+    Description : Write the hit rate of one TLB context switch mode
+    Inputs      : out - file pointer of output file
+                  tc - TLB
+    Outputs     : none
+
+***********************************************************************/
+
+static void tlb_write_mode( FILE *out, tlbcache_t *tc )
+{
+  float hit_ratio = tc->lookups ? (float)tc->hits / (float)tc->lookups : 0.0;
+
+  if ( tc->asids )
+    fprintf( out, "ASID-tagged (%d ASIDs): TLB hit rate = %f; flushes: %llu (ASID rollovers)\n",
+	     tc->asids, hit_ratio, (unsigned long long)tc->flushes );
+  else
+    fprintf( out, "flush on switch: TLB hit rate = %f; flushes: %llu\n",
+	     hit_ratio, (unsigned long long)tc->flushes );
+}
+
+
+/**********************************************************************
+
+    Function    : sim_times
+    Description : Compute the hit ratios and access times of the current machine
+    Inputs      : tlb_hit_ratio - TLB hit ratio (out)
+                  walk - page table levels read per TLB miss (out)
+                  mem_access_time - effective memory-access time, ns (out)
+                  pf_ratio - page fault ratio (out)
+                  access_time - effective access time, ms (out)
+    Outputs     : none
+
+***********************************************************************/
+
+void sim_times( float *tlb_hit_ratio, float *walk, float *mem_access_time,
+		float *pf_ratio, float *access_time )
+{
+  float tlb_miss_ratio, swap_out_ratio, tlb_miss_time, tlb_hit_time;
+
+  *walk = sim->pt_walks ? (float)sim->pt_walk_levels / (float)sim->pt_walks : pt_levels;
+  tlb_miss_ratio = ( (float) sim->memory_accesses / (float) (sim->total_accesses-sim->pfs) );
+  *tlb_hit_ratio = 1.0 - tlb_miss_ratio;
+  tlb_miss_time = TLB_SEARCH_TIME + ( *walk + 1 )*MEMORY_ACCESS_TIME;
+  tlb_hit_time = TLB_SEARCH_TIME + MEMORY_ACCESS_TIME;
+  *mem_access_time = tlb_miss_ratio*tlb_miss_time + *tlb_hit_ratio*tlb_hit_time;
+
+  *pf_ratio = ( (float)sim->pfs / (float)sim->total_accesses );
+  swap_out_ratio = ( (float)sim->swaps / (float)sim->pfs );
+  *access_time = *tlb_hit_ratio*tlb_hit_time + tlb_miss_ratio*(1-*pf_ratio)*(tlb_miss_time) + tlb_miss_ratio*(*pf_ratio)*(PF_OVERHEAD + SWAP_IN_OVERHEAD + RESTART_OVERHEAD + swap_out_ratio*SWAP_OUT_OVERHEAD)
+    + (float)sim->huge_promotions*HUGE_FILL_OVERHEAD / (float)sim->total_accesses
+    + clean_stall( ) / (float)sim->total_accesses;
+  //  This is just the equation Ghosh gave us in class
+  //  (plus reading in the rest of each promoted huge page, and any
+  //  cleaner write-back the disk could not fit in while idle)
+}
+
+
+/**********************************************************************
+
+    Function    : write_compare
+    Description : Write the results of several machines side by side
+    Inputs      : out - file pointer of output file
+                  sims - the machines, one per replacement mechanism
+                  n - number of machines
+    Outputs     : 0 if successful, <0 otherwise
+
+***********************************************************************/
+
+int write_compare( FILE *out, sim_t **sims, int n )
+{
+  float tlb_hit_ratio, walk, mem_access_time, pf_ratio, access_time;
+  int i;
+
+  fprintf( out, "++++++++++++++++++++ Replacement Mechanisms Compared ++++++++++++++++++\n" );
+  fprintf( out, "%llu accesses; %d frames; %d TLB entries\n",
+	   (unsigned long long)sims[0]->total_accesses, sims[0]->frames, sims[0]->tlb_entries );
+  fprintf( out, "%-8s %10s %10s %10s %10s %12s %12s %14s\n", "mech", "faults", "fault%",
+	   "swaps", "invals", "TLB hit", "EMAT (ns)", "EAT (ms)" );
+
+  for ( i = 0; i < n; i++ ) {
+    sim = sims[i];
+    sim_times( &tlb_hit_ratio, &walk, &mem_access_time, &pf_ratio, &access_time );
+    fprintf( out, "%-8s %10llu %10.4f %10llu %10llu %12f %12f %14f\n",
+	     pt_mech_names[sim->mech], (unsigned long long)sim->pfs, pf_ratio * 100.0,
+	     (unsigned long long)sim->swaps, (unsigned long long)sim->invalidates,
+	     tlb_hit_ratio, mem_access_time, access_time );
+  }
+
+  if ( sims[0]->ra == NULL )
+    return 0;
+
+  fprintf( out, "++++++++++++++++++++ Readahead Compared ++++++++++++++++++\n" );
+  fprintf( out, "%-8s %10s %10s %10s %10s %10s %10s %10s\n", "mech", "faults", "no RA",
+	   "fewer%", "read", "hits", "misses", "accuracy" );
+
+  for ( i = 0; i < n; i++ ) {
+    sim = sims[i];
+    fprintf( out, "%-8s %10llu ", pt_mech_names[sim->mech], (unsigned long long)sim->pfs );
+    if ( sim->ra_base )
+      fprintf( out, "%10llu %10.2f ", (unsigned long long)sim->ra_base->pfs, sim->ra_base->pfs ?
+	       100.0 * ( (double)sim->ra_base->pfs - (double)sim->pfs ) / sim->ra_base->pfs : 0.0 );
+    else
+      fprintf( out, "%10s %10s ", "-", "-" );
+    fprintf( out, "%10llu %10llu %10llu %10f\n", (unsigned long long)sim->ra_pages,
+	     (unsigned long long)sim->ra_hits, (unsigned long long)sim->ra_misses,
+	     ( sim->ra_hits + sim->ra_misses ) ? (float)sim->ra_hits / ( sim->ra_hits + sim->ra_misses ) : 0.0 );
+  }
+
+  return 0;
+}
+
+
 /**********************************************************************
 
     Function    : write_results
@@ -191,18 +732,23 @@ int main( int argc, char **argv )
 
 int write_results( FILE *out )
 {
-  float tlb_hit_ratio, tlb_miss_ratio, pf_ratio, swap_out_ratio;
+  float tlb_hit_ratio, walk, mem_access_time, pf_ratio, access_time;
+  int i;
+
+  sim_times( &tlb_hit_ratio, &walk, &mem_access_time, &pf_ratio, &access_time );
 
   fprintf( out, "++++++++++++++++++++ Effective Memory-Access Time ++++++++++++++++++\n" );
   fprintf( out, "Assuming,\n %dns TLB search time and %dns memory access time\n", 
 	   TLB_SEARCH_TIME, MEMORY_ACCESS_TIME );
-  tlb_miss_ratio = ( (float) memory_accesses / (float) (total_accesses-pfs) );
-  tlb_hit_ratio = 1.0 - tlb_miss_ratio;
-  fprintf( out, "memory accesses: %d; total memory accesses %d (less page faults)\n", memory_accesses, total_accesses-pfs ); 
+  if ( pt_mode == PT_INVERTED )
+    fprintf( out, "page table: inverted; %d entries (%llu bytes); %f entries read per walk\n",
+	     sim->frames, (unsigned long long)ipt_bytes( ), walk );
+  else
+    fprintf( out, "page table: %d levels; %d nodes (%llu bytes); %f levels read per walk\n",
+	     pt_levels, sim->pt_nodes, (unsigned long long)sim->pt_bytes, walk );
+  fprintf( out, "memory accesses: %llu; total memory accesses %llu (less page faults)\n",
+	   (unsigned long long)sim->memory_accesses, (unsigned long long)( sim->total_accesses-sim->pfs )); 
   fprintf( out, "TLB hit rate = %f\n", tlb_hit_ratio );
-  float tlb_miss_time = TLB_SEARCH_TIME + 2*MEMORY_ACCESS_TIME;
-  float tlb_hit_time = TLB_SEARCH_TIME + MEMORY_ACCESS_TIME;
-  float mem_access_time = tlb_miss_ratio*tlb_miss_time + tlb_hit_ratio*tlb_hit_time;
   fprintf( out, "Effective memory-access time = %fns\n", 
 	   /* Task #3: ADD THIS COMPUTATION */
 	   mem_access_time);
@@ -210,106 +756,237 @@ int write_results( FILE *out )
   fprintf( out, "++++++++++++++++++++ Effective Access Time ++++++++++++++++++\n" );
   fprintf( out, "Assuming,\n %dms average page-fault service time (w/o swap out), a %dms average swap out time, and %dns memory access time\n", 
 	   ( PF_OVERHEAD + SWAP_IN_OVERHEAD + RESTART_OVERHEAD ), SWAP_OUT_OVERHEAD, MEMORY_ACCESS_TIME );
-  fprintf( out, "swaps: %d; invalidates: %d; page faults: %d\n", 
-	   swaps, invalidates, pfs ); 
-  pf_ratio = ( (float)pfs / (float)total_accesses );
-  swap_out_ratio = ( (float)swaps / (float)pfs );
+  fprintf( out, "swaps: %llu; invalidates: %llu; page faults: %llu\n", 
+	   (unsigned long long)sim->swaps, (unsigned long long)sim->invalidates,
+	   (unsigned long long)sim->pfs ); 
   fprintf( out, "Page fault ratio = %f\n", pf_ratio );
+  fprintf( out, "faults from free frames: %llu; faults needing replacement: %llu\n",
+	   (unsigned long long)sim->free_allocs, (unsigned long long)sim->replace_allocs );
   fprintf( out, "Effective access time = %fms\n", 
 	   /* Task #3: ADD THIS COMPUTATION */
-     tlb_hit_ratio*tlb_hit_time + tlb_miss_ratio*(1-pf_ratio)*(tlb_miss_time) + tlb_miss_ratio*pf_ratio*(PF_OVERHEAD + SWAP_IN_OVERHEAD + RESTART_OVERHEAD + swap_out_ratio*SWAP_OUT_OVERHEAD));
-  //  This is just the equation Ghosh gave us in class
+	   access_time );
+
+  fprintf( out, "++++++++++++++++++++ Page Faults by Process ++++++++++++++++++\n" );
+  fprintf( out, "replacement: %s\n", local_mode( ));
+  for ( i = 0; i < max_processes; i++ ) {
+    task_t *t = &sim->processes[i];
+
+    if ( !t->created )
+      continue;
+    fprintf( out, "pid %d: %llu references, %llu faults (fault rate %f); %d frames at exit",
+	     i, (unsigned long long)t->ct, (unsigned long long)t->pfs,
+	     t->ct ? (float)t->pfs / (float)t->ct : 0.0, t->frames );
+    if ( local_quota )
+      fprintf( out, ", quota %d", t->quota );
+    fprintf( out, "\n" );
+  }
+
+  if ( huge_pages ) {
+    fprintf( out, "++++++++++++++++++++ Huge Pages ++++++++++++++++++\n" );
+    fprintf( out, "huge page: %d base pages (%dKB), promoted at %d%% resident; %dms to read in the rest\n",
+	     1 << huge_order, ( page_size >> 10 ) << huge_order, huge_promote, HUGE_FILL_OVERHEAD );
+    fprintf( out, "promotions: %llu (%llu base pages read in); demotions: %llu; reservations given up: %llu\n",
+	     (unsigned long long)sim->huge_promotions, (unsigned long long)sim->huge_prefilled,
+	     (unsigned long long)sim->huge_demotions, (unsigned long long)sim->huge_breaks );
+    fprintf( out, "TLB hits on huge pages: %llu of %llu; TLB reach at exit: %lluKB (%lluKB with base pages only)\n",
+	     (unsigned long long)sim->tlb.huge_hits, (unsigned long long)sim->tlb.hits,
+	     (unsigned long long)( tlb_reach( &sim->tlb ) >> 10 ),
+	     (unsigned long long)(( (uint64_t)sim->tlb_entries * page_size ) >> 10 ));
+  }
+
+  if ( sim->ws )
+    ws_write( out );
+
+  if ( sim->clean )
+    clean_write( out );
+
+  if ( sim->swap )
+    swap_write( out );
+
+  if ( sim->ra )
+    ra_write( out );
+
+  fprintf( out, "++++++++++++++++++++ TLB Across Context Switches ++++++++++++++++++\n" );
+  fprintf( out, "context switches: %llu (simulated TLB: %s)\n", (unsigned long long)sim->switches,
+	   sim->tlb.asids ? "ASID-tagged" : "flush on switch" );
+  if ( sim->tlb.asids )
+    tlb_write_mode( out, &sim->tlb_shadow );
+  tlb_write_mode( out, &sim->tlb );
   return 0;
 }
 
 
 /**********************************************************************
 
-    Function    : page_replacement_init
-    Description : Initialize the system in which we will manage memory
-    Inputs      : fp - input file 
+    Function    : sim_create
+    Description : Create a machine running one replacement mechanism and
+                  make it the current machine (sim)
+    Inputs      : tr - input trace
                   mech - replacement mechanism
-    Outputs     : 0 if successful, <0 otherwise
+                  frames - physical frames
+                  entries - TLB entries
+    Outputs     : machine if successful, NULL otherwise
 
 ***********************************************************************/
 
-int page_replacement_init( FILE *fp, int mech )
+sim_t *sim_create( trace_t *tr, int mech, int frames, int entries )
 {
-  int i;
-  int err;
-  int pid;
-  unsigned int vaddr;
+  if (( sim = (sim_t *)calloc( 1, sizeof(sim_t) )) == NULL )
+    return NULL;
 
-  fseek( fp, 0, SEEK_SET );  /* start at beginning */
+  sim->current_pid = -1;      /* no process has run yet */
+  sim->frames = frames;
+  sim->tlb_entries = entries;
 
-  /* initialize process table, frame table, and TLB */
-  memset( processes, 0, sizeof(task_t) * MAX_PROCESSES );
-  memset( physical_mem, 0, sizeof(frame_t) * PHYSICAL_FRAMES );
-  tlb_flush( );
-  current_pt = 0;
+  if ( config_tlb( entries, &sim->tlb_ways, &sim->tlb_set_mask ) ||
+       page_replacement_init( tr, mech )) {
+    sim_destroy( sim );
+    return NULL;
+  }
 
-  /* initialize frames with numbers */
-  for ( i = 0; i < PHYSICAL_FRAMES ; i++ ) {
-    physical_mem[i].number = i;
+  return sim;
+}
+
+
+/**********************************************************************
+
+    Function    : pt_free_node
+    Description : free a radix page table node and the levels below it
+    Inputs      : node - page table node
+                  level - level of the node (0 is the root)
+    Outputs     : none
+
+***********************************************************************/
+
+static void pt_free_node( void **node, int level )
+{
+  size_t n = (size_t)1 << pt_level_bits[level];
+  size_t i;
+
+  if ( level < pt_levels - 1 ) {
+    for ( i = 0; i < n; i++ ) {
+      if ( node[i] )
+	pt_free_node( (void **)node[i], level + 1 );
+    }
   }
 
-  /* create processes, including initial page table */
-  while ( fscanf( fp, "%d %x\n", &pid, &vaddr ) == 2 ) {
-    
-    if ( processes[pid].pagetable == NULL ) {
-      err = process_create( pid );
+  free( node );
+}
 
-      if ( err ) 
-	return -1;
+
+/**********************************************************************
+
+    Function    : sim_destroy
+    Description : Free a machine and everything it allocated
+    Inputs      : s - machine
+    Outputs     : none
+
+***********************************************************************/
+
+void sim_destroy( sim_t *s )
+{
+  sim_t *base = s->ra_base;
+  int i;
+
+  sim = s;
+
+  /* local replacement: each process's state, then the one from init */
+  if ( s->repl_model ) {
+    for ( i = 0; s->processes && ( i < max_processes ); i++ ) {
+      if (( s->repl = s->processes[i].repl ) != NULL )
+	pt_replace_exit[s->mech]( );
     }
+    s->repl = s->repl_model;
   }
 
-  fseek( fp, 0, SEEK_SET );  /* reset at beginning */
-  
-  /* init replacement specific data */
-  pt_replace_init[mech]( fp );
+  if ( s->repl )
+    pt_replace_exit[s->mech]( );
 
-  return 0;
+  if ( s->processes ) {
+    for ( i = 0; i < max_processes; i++ ) {
+      if ( s->processes[i].pagetable )
+	pt_free_node( s->processes[i].pagetable, 0 );
+    }
+  }
+
+  ws_exit( );
+  local_exit( );
+  clean_exit( );
+  swap_exit( );
+  ra_exit( );
+  tlb_exit( );
+  ipt_exit( );
+  free( s->processes );
+  free( s->physical_mem );
+  free( s->free_frames );
+  free( s );
+
+  sim = NULL;
+  if ( base )
+    sim_destroy( base );
 }
 
 
 /**********************************************************************
 
-    Function    : process_create
-    Description : Initialize process's task structure
-    Inputs      : pid - id (and index) of process
+    Function    : page_replacement_init
+    Description : Initialize the system in which we will manage memory
+    Inputs      : tr - input trace
+                  mech - replacement mechanism
     Outputs     : 0 if successful, <0 otherwise
 
 ***********************************************************************/
 
-int process_create( int pid )
+int page_replacement_init( trace_t *tr, int mech )
 {
-  ptentry_t *pgtable;
   int i;
 
-  assert( pid >= 0 );
-  assert( pid < MAX_PROCESSES );
-
-  /* initialize to zero -- particularly for stats */
-  memset( &processes[pid], 0, sizeof(task_t) );
+  /* allocate process table, frame table, and TLB for this geometry */
+  sim->processes = (task_t *)malloc( sizeof(task_t) * max_processes );
+  sim->physical_mem = (frame_t *)malloc( sizeof(frame_t) * sim->frames );
 
-  /* set process data */
-  processes[pid].pid = pid;
-  pgtable = (ptentry_t *)malloc( sizeof(ptentry_t) * VIRTUAL_PAGES );  
+  sim->free_words = BITMAP_WORDS( sim->frames );
+  sim->free_frames = (uint64_t *)calloc( sim->free_words, sizeof(uint64_t) );
 
-  if ( pgtable == 0 )
+  if (( sim->processes == NULL ) || ( sim->physical_mem == NULL ) || ( sim->free_frames == NULL ) ||
+      tlb_init( ) || (( pt_mode == PT_INVERTED ) && ipt_init( )) ||
+      ( ws_window && ws_init( )) || ( local_quota && local_init( )) || ( clean_low && clean_init( )) ||
+      ( swap_path && swap_init( )) || ( readahead_max && ra_init( )))
     return -1;
 
-  /* initialize page table */
-  memset( pgtable, 0, (sizeof(ptentry_t) * VIRTUAL_PAGES ));
+  /* initialize process table, frame table, and TLB */
+  /* processes are created on their first reference (see context_switch) */
+  memset( sim->processes, 0, sizeof(task_t) * max_processes );
+  memset( sim->physical_mem, 0, sizeof(frame_t) * sim->frames );
 
-  /* assign numbers to pages in page table */
-  for ( i = 0; i < VIRTUAL_PAGES ; i++ ) {
-    pgtable[i].number = i;
+  /* initialize frames with numbers */
+  for ( i = 0; i < sim->frames ; i++ ) {
+    sim->physical_mem[i].number = i;
+    BITMAP_SET( sim->free_frames, i );
   }
+  sim->free_hint = 0;
+
+  /* policies that look ahead read the trace here, so it must be re-readable */
+  if ( pt_replace_lookahead[mech] ) {
+    if ( trace_rewind( tr )) {
+      fprintf( stderr, "replacement mechanism %d needs a seekable trace\n", mech );
+      return -1;
+    }
+  }
+
+  /* init replacement specific data */
+  sim->mech = mech;
+  sim->trace = tr;
+  if ( pt_replace_init[mech]( tr ))
+    return -1;
 
-  /* store process's page table */
-  processes[pid].pagetable = pgtable;
+  /* local replacement makes a state per process as it first needs one */
+  if ( local_quota )
+    sim->repl_model = sim->repl;
+
+  /* lookahead policies leave the trace wherever they stopped */
+  if ( pt_replace_lookahead[mech] )
+    trace_rewind( tr );
 
   return 0;
 }
@@ -317,56 +994,74 @@ int process_create( int pid )
 
 /**********************************************************************
 
-    Function    : get_memory_access
-    Description : Determine the address accessed 
-    Inputs      : fp - file pointer
-                  pid - process id
-                  vaddr - address of access
-                  eof - are we done?
-    Outputs     : 0 if successful, <0 otherwise
+    Function    : pt_alloc_node
+    Description : allocate a zeroed radix page table node.  Leaves hold
+                  page table entries, numbered for the pages they cover;
+                  other levels hold pointers to the next level
+    Inputs      : level - level of the node (0 is the root)
+                  page - any page number the node covers
+    Outputs     : node if successful, NULL otherwise
 
 ***********************************************************************/
 
-int get_memory_access( FILE *fp, int *pid, unsigned int *vaddr, int *op, int *eof )
+static void *pt_alloc_node( int level, vpn_t page )
 {
-  int err = 0;
-  *op = 0;   /* read */
-
-  /* create processes, including initial page table */
-  if ( fscanf( fp, "%d %x\n", pid, vaddr ) == 2 );
-  else *eof = 1;
-
-  if (*eof != 1){
-    /* write: for certain addresses (< 0x200) */
-    if (( *vaddr - (( *vaddr / PAGE_SIZE ) * PAGE_SIZE)) < 0x200 ) {
-      *op = 1; 
-      printf( "=== get_memory_access: process %d writes at 0x%x\n", *pid, *vaddr );
-    }else{
-      printf( "=== get_memory_access: process %d reads at 0x%x\n", *pid, *vaddr ); 
-    }
+  size_t n = (size_t)1 << pt_level_bits[level];
+  size_t size = ( level == pt_levels - 1 ) ? sizeof(ptentry_t) : sizeof(void *);
+  size_t extra = ( huge_pages && ( level == pt_levels - 1 )) ? huge_leaf_extra( n ) : 0;
+  ptentry_t *leaf;
+  void *node;
+  size_t i;
+
+  if (( node = calloc( 1, n * size + extra )) == NULL )
+    return NULL;
+
+  if ( level == pt_levels - 1 ) {
+    leaf = (ptentry_t *)node;
+    page &= ~(vpn_t)( n - 1 );
+    for ( i = 0; i < n; i++ )
+      leaf[i].number = page + i;
+    if ( extra )
+      huge_leaf_init( leaf, n );
   }
 
-  return err;
+  sim->pt_nodes++;
+  sim->pt_bytes += n * size + extra;
+
+  return node;
 }
 
 
 /**********************************************************************
 
-    Function    : context_switch
-    Description : Switch from one process id to another 
-    Inputs      : pid - new process id
+    Function    : process_create
+    Description : Initialize process's task structure
+    Inputs      : pid - id (and index) of process
     Outputs     : 0 if successful, <0 otherwise
 
 ***********************************************************************/
 
-int context_switch( int pid )
+int process_create( int pid )
 {
-  /* flush tlb */
-  tlb_flush( );
+  assert( pid >= 0 );
+  assert( pid < max_processes );
 
-  /* switch page tables */
-  current_pt = processes[pid].pagetable;
-  current_pid = pid;
+  /* initialize to zero -- particularly for stats */
+  memset( &sim->processes[pid], 0, sizeof(task_t) );
+
+  /* set process data */
+  sim->processes[pid].pid = pid;
+  sim->processes[pid].created = 1;
+
+  /* the inverted page table is shared; nothing to allocate */
+  if ( pt_mode == PT_INVERTED )
+    return 0;
+
+  /* the root of the page table; lower levels are allocated on demand */
+  sim->processes[pid].pagetable = (void **)pt_alloc_node( 0, 0 );
+
+  if ( sim->processes[pid].pagetable == NULL )
+    return -1;
 
   return 0;
 }
@@ -374,105 +1069,105 @@ int context_switch( int pid )
 
 /**********************************************************************
 
-    Function    : tlb_flush
-    Description : set the TLB entries to TLB_INVALID
-    Inputs      : none
-    Outputs     : 1 if hit, 0 if miss
+    Function    : pt_lookup
+    Description : walk a process's radix page table to a page's entry,
+                  or probe the inverted page table
+    Inputs      : pid - process id
+                  page - page number
+                  create - allocate missing nodes on the way down (radix)
+                  levels - if not NULL, add the levels (or probes) read
+    Outputs     : page table entry, or NULL if the page has none (and
+                  create is 0, or allocation failed)
 
 ***********************************************************************/
 
-int tlb_flush( void )
+ptentry_t *pt_lookup( int pid, vpn_t page, int create, int *levels )
 {
+  void **node = sim->processes[pid].pagetable;
+  void **slot;
   int i;
 
-  for ( i = 0; i < TLB_ENTRIES; i++ ) {
-    tlb[i].page = TLB_INVALID;
-    tlb[i].frame = TLB_INVALID;
-    tlb[i].op = TLB_INVALID;
+  /* the inverted table only has entries for resident pages */
+  if ( pt_mode == PT_INVERTED )
+    return ipt_lookup( pid, page, levels );
+
+  for ( i = 0; i < pt_levels - 1; i++ ) {
+    slot = &node[( page >> pt_level_shift[i] ) & (( (vpn_t)1 << pt_level_bits[i] ) - 1 )];
+    if ( levels )
+      (*levels)++;
+
+    if (( *slot == NULL ) && ( !create || (( *slot = pt_alloc_node( i + 1, page )) == NULL )))
+      return NULL;
+
+    node = (void **)*slot;
   }
-  
-  return 0;
+
+  if ( levels )
+    (*levels)++;
+
+  return &((ptentry_t *)node)[page & (( (vpn_t)1 << pt_level_bits[i] ) - 1 )];
 }
 
 
 /**********************************************************************
 
-    Function    : tlb_resolve_addr
-    Description : convert vaddr to paddr if a hit in the tlb
-    Inputs      : vaddr - virtual address 
-                  paddr - physical address
-                  op - 0 for read, 1 for read-write
-    Outputs     : 1 if hit, 0 if miss
+    Function    : get_memory_access
+    Description : Determine the address accessed 
+    Inputs      : tr - input trace
+                  pid - process id
+                  vaddr - address of access
+                  op - read (0) or write (1)
+                  eof - are we done?
+    Outputs     : 0 if successful, <0 otherwise
 
 ***********************************************************************/
 
-/* note: normally, the operations associated with a page are based on the address space
-   segments in the ELF binary (read-only, read-write, execute-only).  Assume that this is 
-   already done */
-
-int tlb_resolve_addr( unsigned int vaddr, unsigned int *paddr, int op )
+int get_memory_access( trace_t *tr, int *pid, vaddr_t *vaddr, int *op, int *eof )
 {
-  // GHOSH SAID HINT IN pt_demand_page
-  /* Task #2 */
-  unsigned int page = ( vaddr / PAGE_SIZE );
+  int ret;
+  *op = 0;   /* read */
 
-  int i;
-  for(i = 0; i < TLB_ENTRIES; i++){
-    if(tlb[i].page == page){
-      *paddr = (tlb[i].page * PAGE_SIZE) + ( vaddr % PAGE_SIZE );
-      printf("tlb_resolve_addr: TLB hit, paddr = %#x\n", *paddr);
-      current_pt[page].ct++;
-      hw_update_pageref(&current_pt[page], op);
-      return 1;
-    }
-  }
-  printf("tlb_resolve_addr: TLB miss\n");
-  return 0;  /* miss */
+  /* text traces derive the op from the address; binary traces carry it */
+  if (( ret = trace_next( tr, pid, vaddr, op )) < 0 )
+    return -1;
+  if ( ret == 0 )
+    *eof = 1;
+
+  return 0;
 }
 
+
 /**********************************************************************
 
-    Function    : tlb_update_pageref
-    Description : associate page and frame in TLB
-    Inputs      : frame - frame number
-                  page - page number
-                  op - operation - read (0) or write (1)
-    Outputs     : 1 if hit, 0 if miss
+    Function    : context_switch
+    Description : Switch from one process id to another 
+    Inputs      : pid - new process id
+    Outputs     : 0 if successful, <0 otherwise
 
 ***********************************************************************/
 
-int tlb_update_pageref( int frame, int page, int op )
+int context_switch( int pid )
 {
-  int i;
-
-  /* replace old entry */
-  for ( i = 0; i < TLB_ENTRIES; i++ ) {
-    if ( tlb[i].frame == frame ) {
-      tlb[i].page = page;
-      tlb[i].op = op;
-      return 0;
-    }
+  /* first reference to this pid: create its task and page table */
+  if ( !sim->processes[pid].created ) {
+    if ( process_create( pid ))
+      return -1;
+    /* a process arrived: split the frames again */
+    if ( local_quota )
+      local_rebalance( );
   }
 
-  /* or add anywhere in tlb */
-  for ( i = 0; i < TLB_ENTRIES; i++ ) {
-    if ( tlb[i].page == TLB_INVALID ) {
-      tlb[i].page = page;
-      tlb[i].frame = frame;
-      tlb[i].op = op;
-      return 0;
-    } 
-  }
+  /* flush the tlb, or just switch its address space if tagged */
+  tlb_switch( pid );
+  sim->switches++;
 
-  /* or pick any entry to toss -- random entry */
-  i = random()%TLB_ENTRIES;
-  tlb[i].page = page;
-  tlb[i].frame = frame;
-  tlb[i].op = op;
+  /* switch page tables */
+  sim->current_pid = pid;
 
   return 0;
 }
 
+
 /**********************************************************************
 
     Function    : pt_resolve_addr
@@ -485,28 +1180,94 @@ int tlb_update_pageref( int frame, int page, int op )
 
 ***********************************************************************/
 
-int pt_resolve_addr( unsigned int vaddr, unsigned int *paddr, int *valid, int op )
+int pt_resolve_addr( vaddr_t vaddr, uint64_t *paddr, int *valid, int op )
 {
 
   /* Task #2 */
-  unsigned int page = ( vaddr / PAGE_SIZE );
-  
-  *valid = current_pt[page].bits & VALIDBIT; // Set valid to whatever the status of the page's valid bit is
+  vpn_t page = ( vaddr >> page_shift );
+  int levels = 0;
+  ptentry_t *pte = pt_lookup( sim->current_pid, page, 0, &levels );
+
+  sim->pt_walks++;
+  sim->pt_walk_levels += levels;
+
+  *valid = pte && ( pte->bits & VALIDBIT ); // Set valid to whatever the status of the page's valid bit is
 
   if(*valid){ // If the page is valid (i.e. in memory) calculate its paddr and return 0
-    *paddr = (current_pt[page].frame * PAGE_SIZE) + ( vaddr % PAGE_SIZE );
-    printf("pt_resolve_addr: page table hit, paddr = %#x\n", *paddr);
-    current_pt[page].ct++;
-    memory_accesses++;
-    hw_update_pageref(&current_pt[page], op);
+    *paddr = ((uint64_t)pte->frame << page_shift) + ( vaddr & page_mask );
+    EVENT( LOG_FULL, EV_PT_HIT, sim->current_pid, vaddr, pte->frame, 0 );
+    pt_count_ref(sim->current_pid, pte);
+    sim->memory_accesses++;
+    hw_update_pageref(pte, op);
+    tlb_update_pageref(pte, op); /* the walk refills the TLB */
     return 0;
   }
   // Else we have a page fault
-  printf("pt_resolve_addr: page fault\n");
+  EVENT( LOG_FAULTS, EV_PAGE_FAULT, sim->current_pid, vaddr, -1, 0 );
   return -1;
 }
 
 
+/**********************************************************************
+
+    Function    : pt_take_frame
+    Description : find a frame for a page being read in: its frame of a
+                  huge page reservation, a free frame, or else one page
+                  replacement frees
+    Inputs      : pid - process id
+                  page - page number
+                  pte - the page's entry (radix tables), else NULL
+                  mech - replacement mechanism
+                  fp - the frame (out)
+                  other_pid - process whose page was replaced, or -1 (out)
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+static int pt_take_frame( int pid, vpn_t page, ptentry_t *pte, int mech,
+			  frame_t **fp, int *other_pid )
+{
+  frame_t *f = (frame_t *)NULL;
+  int i, owner;
+
+  *other_pid = -1;
+
+  /* huge pages: a page of a reserved region faults into its frame of the block */
+  i = huge_pages ? huge_frame( pid, pte ) : -1;
+
+  /* else find a free frame -- lowest numbered, from the free frame bitmap --
+     taking back reserved frames before replacing any page.  Under local
+     replacement, a process at its quota replaces one of its own pages */
+  if (( i < 0 ) && !( local_quota && local_full( pid ))) {
+    while ((( i = pt_find_free_frame( )) < 0 ) && huge_pages && !huge_break_oldest( ));
+  }
+
+  if ( i >= 0 )
+    f = &sim->physical_mem[i];
+
+  /* if no free frame, run page replacement */
+  if ( f == NULL ) {
+    /* adaptive policies learn from the miss */
+    sim->fault_pid = pid;
+    sim->fault_page = page;
+    if ( local_quota ) {
+      /* local page replacement -- the victim comes from the process the
+	 quotas say gives up a frame, which then forgets the frame */
+      if ((( owner = local_owner( pid )) < 0 ) || pt_replacement_of( owner ) || pt_choose_victim[mech]( other_pid, &f ))
+	return -1;
+      pt_release_replacement[mech]( *other_pid, f );
+    }
+    else
+      /* global page replacement */
+      pt_choose_victim[mech]( other_pid, &f );
+    pt_invalidate_mapping( *other_pid, f->page );  
+  }
+
+  *fp = f;
+  return 0;
+}
+
+
 /**********************************************************************
 
     Function    : pt_demand_page
@@ -521,51 +1282,108 @@ int pt_resolve_addr( unsigned int vaddr, unsigned int *paddr, int *valid, int op
 ***********************************************************************/
 
 // called for every page access
-int pt_demand_page( int pid, unsigned int vaddr, unsigned int *paddr, int op, int mech )
+int pt_demand_page( int pid, vaddr_t vaddr, uint64_t *paddr, int op, int mech )
 { 
-  int i;
-  unsigned int page = ( vaddr / PAGE_SIZE );
+  vpn_t page = ( vaddr >> page_shift );
   frame_t *f = (frame_t *)NULL;
-  int other_pid;
+  int other_pid = -1;
+  ptentry_t *pte = NULL;
 
-  pfs++;
+  /* radix tables: the walk allocates any page table nodes the page is missing */
+  if (( pt_mode == PT_RADIX ) && (( pte = pt_lookup( pid, page, 1, NULL )) == NULL ))
+    return -1;
 
-  /* find a free frame */
-  /* NOTE: maintain a free frame list */
-  for ( i = 0; i < PHYSICAL_FRAMES; i++ ) {
-    if ( !physical_mem[i].allocated ) { 
-      f = &physical_mem[i];
+  sim->pfs++;
+  sim->processes[pid].pfs++;
 
-      pt_alloc_frame( pid, f, &current_pt[page], 1, mech );  /* alloc for read/write */
-      printf("pt_demand_page: free frame -- pid: %d; vaddr: 0x%x; frame num: %d\n", 
-	     pid, vaddr, f->number);
-      break;
-    }
-  }
+  /* a fault continuing a sequential or strided stream reads ahead first */
+  if ( sim->ra && ( ra_fault( pid, page, mech ) < 0 ))
+    return -1;
 
-  /* if no free frame, run page replacement */
-  if ( f == NULL ) {
-    /* global page replacement */
-    pt_choose_victim[mech]( &other_pid, &f );
-    pt_invalidate_mapping( other_pid, f->page );  
-    pt_alloc_frame( pid, f, &current_pt[page], 1, mech );  /* alloc for read/write */
-    printf("pt_demand_page: replace -- pid: %d; vaddr: 0x%x; victim frame num: %d\n", 
-	   pid, vaddr, f->number);
-  }
+  if ( pt_take_frame( pid, page, pte, mech, &f, &other_pid ))
+    return -1;
+  if ( other_pid < 0 )
+    sim->free_allocs++;
+  else
+    sim->replace_allocs++;
+
+  /* the inverted table's entry for the page is the frame's own */
+  if ( pt_mode == PT_INVERTED )
+    pte = ipt_insert( pid, page, f->number );
+
+  /* the page is dirty only if the faulting reference writes it */
+  if ( pt_alloc_frame( pid, f, pte, op, mech ))
+    return -1;
+  if ( other_pid < 0 )
+    EVENT( LOG_FAULTS, EV_FREE_FRAME, pid, vaddr, f->number, 0 );
+  else
+    EVENT( LOG_FAULTS, EV_REPLACE, pid, vaddr, f->number, other_pid );
+
+  /* enough of the region resident now? map it as a huge page */
+  if ( huge_pages )
+    huge_check_promote( pte, mech );
 
   /* compute new physical addr */
-  *paddr = ( f->number * PAGE_SIZE ) + ( vaddr % PAGE_SIZE );
+  *paddr = ( (uint64_t)f->number << page_shift ) + ( vaddr & page_mask );
   
   /* do hardware update to page */
-  hw_update_pageref( &current_pt[page], op );
-  current_pt[page].ct++;
-  tlb_update_pageref( f->number, page, op );
-  printf("pt_demand_page: addr -- pid: %d; vaddr: 0x%x; paddr: 0x%x\n", 
-	   pid, vaddr, *paddr);
+  hw_update_pageref( pte, op );
+  pt_count_ref( pid, pte );
+  tlb_update_pageref( pte, op );
+  EVENT( LOG_FULL, EV_MAP, pid, vaddr, f->number, 0 );
+
+  /* the cleaner writes back while the process waits for its page */
+  if ( sim->clean && ( clean_wake( ) < 0 ))
+    return -1;
 
   return 0;
 }
 
+
+/**********************************************************************
+
+    Function    : pt_prefetch_page
+    Description : read a page in ahead of its first reference: loaded
+                  clean and unreferenced, into a free frame or else one
+                  page replacement gives up
+    Inputs      : pid - process id
+                  page - page number
+                  mech - replacement mechanism
+    Outputs     : 1 if read in, 0 if already resident, -1 on failure
+
+***********************************************************************/
+
+int pt_prefetch_page( int pid, vpn_t page, int mech )
+{
+  frame_t *f = (frame_t *)NULL;
+  int other_pid = -1;
+  ptentry_t *pte;
+
+  pte = pt_lookup( pid, page, ( pt_mode == PT_RADIX ), NULL );
+  if (( pt_mode == PT_RADIX ) && ( pte == NULL ))
+    return -1;
+  if ( pte && ( pte->bits & VALIDBIT ))
+    return 0;
+
+  if ( pt_take_frame( pid, page, pte, mech, &f, &other_pid ))
+    return -1;
+
+  if ( pt_mode == PT_INVERTED )
+    pte = ipt_insert( pid, page, f->number );
+
+  sim->prefetching = 1;
+  if ( pt_alloc_frame( pid, f, pte, 0, mech ))
+    return -1;
+  EVENT( LOG_FAULTS, EV_PREFETCH, pid, page, f->number, other_pid );
+
+  if ( huge_pages )
+    huge_check_promote( pte, mech );
+  sim->prefetching = 0;
+
+  return 1;
+}
+
+
 /**********************************************************************
 
     Function    : pt_invalidate_mapping
@@ -576,21 +1394,149 @@ int pt_demand_page( int pid, unsigned int vaddr, unsigned int *paddr, int op, in
 
 ***********************************************************************/
 
-int pt_invalidate_mapping( int pid, int page )
+int pt_invalidate_mapping( int pid, vpn_t page )
 {
   /* Task #3 */
-  printf("pt_invalidate_mapping: Invalidating process %i page %i\n", pid, page);
-  invalidates++; // Increment count of invalidations
-  physical_mem[processes[pid].pagetable[page].frame].allocated = 0; // Set the frame to unallocated
+  ptentry_t *pte = pt_lookup( pid, page, 0, NULL );
+
+  EVENT( LOG_FAULTS, EV_INVALIDATE, pid, page, pte->frame, 0 );
+  sim->invalidates++; // Increment count of invalidations
+  pt_free_frame( &sim->physical_mem[pte->frame] ); // Set the frame to unallocated
+
+  // Drop any TLB entry the process still has for the page
+  tlb_invalidate_page( pid, page );
+  if ( huge_pages )
+    huge_unmapped( pte );
+
+  // A page the cleaner wrote back may need no write now
+  if ( sim->clean )
+    clean_evicted( pte->frame, pte->bits & DIRTYBIT );
+  if ( sim->ra )
+    ra_evicted( pte->frame );
 
   // If the dirty bit is set, need to write frame to disk
-  if(processes[pid].pagetable[page].bits & DIRTYBIT){
-    pt_write_frame(&physical_mem[processes[pid].pagetable[page].frame]);
+  if(pte->bits & DIRTYBIT){
+    pt_write_frame(&sim->physical_mem[pte->frame]);
+    sim->dirty--;
+  }
+
+  // Invalidate the page table entry; the swapped copy is clean
+  pte->bits &= REFBIT; // Set valid and dirty bits to 0
+  pte->ct = 0;
+
+  // An inverted table entry belongs to the frame, which is free now
+  if ( pt_mode == PT_INVERTED )
+    ipt_remove( pte->frame );
+
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : pt_swap_out
+    Description : take a resident page out of memory outside of page
+                  replacement (its process is being swapped out); the
+                  mechanism forgets the frame before it is freed
+    Inputs      : pid - process id
+                  f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int pt_swap_out( int pid, frame_t *f )
+{
+  if ( pt_replacement_of( pid ))
+    return -1;
+  pt_release_replacement[sim->mech]( pid, f );
+  return pt_invalidate_mapping( pid, f->page );
+}
+
+
+/**********************************************************************
+
+    Function    : pt_replacement_of
+    Description : make a process's replacement state the current one:
+                  under local replacement each process has its own,
+                  made on first use (an init finds the state made at
+                  machine init in sim->repl, to share what is read-only)
+    Inputs      : pid - process id
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int pt_replacement_of( int pid )
+{
+  task_t *t = &sim->processes[pid];
+
+  if ( !local_quota )
+    return 0;
+
+  if ( t->repl == NULL ) {
+    sim->repl = sim->repl_model;
+    sim->repl_pid = pid;
+    if ( pt_replace_init[sim->mech]( sim->trace ))
+      return -1;
+    t->repl = sim->repl;
   }
 
-  // Invalidate the page table entry
-  processes[pid].pagetable[page].bits &= (DIRTYBIT | REFBIT); // Set valid bit to 0
-  processes[pid].pagetable[page].ct = 0;
+  sim->repl = t->repl;
+  sim->repl_pid = pid;
+  return 0;
+}
+
+
+/**********************************************************************
+
+    Function    : pt_find_free_frame
+    Description : find the lowest numbered free frame, skipping full
+                  words of the free frame bitmap
+    Inputs      : none
+    Outputs     : frame number, or -1 if every frame is allocated
+
+***********************************************************************/
+
+int pt_find_free_frame( void )
+{
+  int w;
+
+  for ( w = sim->free_hint; w < sim->free_words; w++ ) {
+    if ( sim->free_frames[w] ) {
+      sim->free_hint = w;
+      return ( w << 6 ) + __builtin_ctzll( sim->free_frames[w] );
+    }
+  }
+
+  sim->free_hint = sim->free_words;
+  return -1;
+}
+
+
+/**********************************************************************
+
+    Function    : pt_free_frame
+    Description : mark a frame unallocated and return it to the free set
+    Inputs      : f - frame
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int pt_free_frame( frame_t *f )
+{
+  /* reserved frames of a huge page region are freed unallocated */
+  if ( f->allocated ) {
+    sim->processes[f->pid].frames--;
+    if ( local_quota )
+      local_moved( f->pid );
+    if ( sim->ws && load_control )
+      ws_frame_freed( f );
+  }
+
+  f->allocated = 0;
+  BITMAP_SET( sim->free_frames, f->number );
+
+  if (( f->number >> 6 ) < sim->free_hint )
+    sim->free_hint = f->number >> 6;
 
   return 0;
 }
@@ -608,9 +1554,10 @@ int pt_invalidate_mapping( int pid, int page )
 int pt_write_frame( frame_t *f )
 {
   /* collect some stats */
-  swaps++;
+  sim->swaps++;
 
-  return 0;
+  /* a real swap file queues the page's contents for writing */
+  return sim->swap ? swap_out( f ) : 0;
 }
 
 
@@ -629,25 +1576,63 @@ int pt_write_frame( frame_t *f )
 int pt_alloc_frame( int pid, frame_t *f, ptentry_t *ptentry, int op, int mech )
 {
   /* Task #3 */
-  printf("pt_alloc_frame: Allocating frame %i to process %i page %i\n", f->number, pid, ptentry->number);
+  EVENT( LOG_FAULTS, EV_ALLOC, pid, ptentry->number, f->number, op );
   /* initialize page frame */
   f->allocated = 1;
+  BITMAP_CLEAR( sim->free_frames, f->number );
   f->page = ptentry->number;
+  f->pid = pid;
   f->op = op;
+  sim->processes[pid].frames++;
+  if ( local_quota )
+    local_moved( pid );
+  if ( sim->ws && load_control )
+    ws_frame_taken( f );
 
   ptentry->frame = f->number;
   ptentry->bits |= VALIDBIT; // Set valid bit to 1
+  if ( sim->swap && swap_in( f ))
+    return -1;
   hw_update_pageref(ptentry, op); // Set other bits
   ptentry->op = op;
   ptentry->ct = 0;
 
+  if ( huge_pages )
+    huge_mapped( ptentry );
+
   /* update the replacement info */
+  if ( pt_replacement_of( pid ))
+    return -1;
   pt_update_replacement[mech]( pid, f );
 
   return 0;
 }
 
 
+/**********************************************************************
+
+    Function    : pt_count_ref
+    Description : count a reference to a resident page and let the
+                  replacement mechanism update its state in place
+    Inputs      : pid - process id
+                  ptentry - page table entry of the (valid) page
+    Outputs     : 0 if successful, -1 otherwise
+
+***********************************************************************/
+
+int pt_count_ref( int pid, ptentry_t *ptentry )
+{
+  ptentry->ct++;
+  if ( sim->clean )
+    clean_ref( ptentry->frame );
+  if ( sim->ra )
+    ra_ref( ptentry->frame );
+  if ( local_quota && pt_replacement_of( pid ))
+    return -1;
+  return pt_ref_replacement[sim->mech]( pid, &sim->physical_mem[ptentry->frame] );
+}
+
+
 /**********************************************************************
 
     Function    : hw_update_pageref
@@ -665,6 +1650,13 @@ int hw_update_pageref( ptentry_t *ptentry, int op )
   ptentry->bits |= REFBIT; // set ref to 1
 
   if ( op ) {   /* write */
+    if ( !( ptentry->bits & DIRTYBIT )) {
+      sim->dirty++;
+      if ( sim->swap )
+	swap_dirtied( &sim->physical_mem[ptentry->frame] );
+    }
+    if ( sim->swap )
+      swap_stamp( ptentry->frame );
     ptentry->bits |= DIRTYBIT; // set dirty to 1
   }
 
@@ -1,11 +1,38 @@
 #define TRUE             1
+
+/* default geometry -- set at runtime with options or a config file */
 #define PAGE_SIZE        0x1000
-#define VIRTUAL_PAGES    64 // every process has this many pages in its table
+#define VA_BITS          32 // bits of virtual address space per process
+#define PT_LEVELS        2  // radix page table levels (1-4)
+#define PT_MAX_LEVELS    4
+#define PT_RADIX         0  // per-process radix page tables
+#define PT_INVERTED      1  // one hashed inverted page table for all processes
+#define HUGE_ORDER       9  // a huge page is 2^HUGE_ORDER base pages (2MB of 4KB)
+#define HUGE_PROMOTE     50 // percent of a reserved region resident to promote it
 #define PHYSICAL_FRAMES  4
 #define MAX_PROCESSES    10
 #define TLB_ENTRIES      16
 #define WRITE_FRAC       15
 #define TLB_INVALID      -1
+#define TLB_WAYS         0  // 0 = fully associative
+#define TLB_REPL_LRU     0
+#define TLB_REPL_PLRU    1
+#define TLB_ASIDS        256 // address-space IDs for a tagged TLB
+#define WS_WINDOW        1000 // working set window, in references of the process
+#define LOAD_OFF         0  // no load control
+#define LOAD_WS          1  // keep the running working sets within the frames
+#define LOAD_PFF         2  // keep the page-fault frequency within bounds
+#define PFF_HIGH         10 // percent of references faulting: suspend a process
+#define PFF_LOW          2  // ... and resume one
+#define LOCAL_GLOBAL     0  // global replacement: any process's page may be the victim
+#define LOCAL_FIXED      1  // local replacement, frames split equally
+#define LOCAL_PROP       2  // ... in proportion to the working sets
+#define LOCAL_PFF        3  // ... adapted to each process's page-fault frequency
+#define CLEAN_BATCH      16 // pages the cleaner writes back together
+#define SWAP_BATCH       16 // evicted pages written to the swap file together
+#define SWAP_TAG_BYTES   16 // page contents start with the page's name and write count
+#define RA_MIN           4  // readahead window of a newly detected stream, in pages
+#define RA_MAX           32 // ... and the largest it grows to
 
 /* bitmasks */
 #define VALIDBIT          0x1
@@ -19,10 +46,16 @@
 #define SWAP_IN_OVERHEAD   12     /* in ms */
 #define SWAP_OUT_OVERHEAD  12     /* in ms */
 #define RESTART_OVERHEAD   1      /* in ms */
+#define HUGE_FILL_OVERHEAD 20     /* in ms: read in the rest of a huge page */
+#define CLEAN_PAGE_OVERHEAD 1     /* in ms: each further page of a write-back batch */
+
+/* virtual addresses and virtual page numbers */
+typedef uint64_t vaddr_t;
+typedef uint64_t vpn_t;
 
 /* page table entry */
-typedef struct ptentry {                                         // ptentry_t *current_pt;
-  int number; //index
+typedef struct ptentry {                                         // leaf of a radix page table
+  vpn_t number; //index
   int frame; //(0-4)?
   int bits;  /* ref, dirty */
   int op; // 0=read 1=write
@@ -31,75 +64,741 @@ typedef struct ptentry {                                         // ptentry_t *c
 
 
 // Frames are on RAM, 4 of them (see line 4)
-typedef struct frame {                                           // frame_t physical_mem[PHYSICAL_FRAMES];
+typedef struct frame {                                           // frame_t physical_mem[physical_frames];
   int number; //index
   int allocated; // Whether frame is free or not
-  int page;
+  vpn_t page;
+  int pid;      // process owning the page
   int op;
 } frame_t;
 
 
 /* TLB entry */
 typedef struct tlbentry {
-  int page; 
+  vpn_t page; 
   int frame;
   int op; 
+  uint64_t stamp;  /* last use, for LRU within the set */
+  int mru;         /* recently used bit, for pseudo-LRU within the set */
+  int asid;        /* address space the entry belongs to */
+  int huge;        /* maps a huge page: page is the huge page number */
+  uint32_t gen;    /* ASID generation; stale generations are invalid */
+  ptentry_t *pte;  /* page table entry, for the ref and dirty bits */
 } tlb_t;
 
 
+/* a TLB: tlb_entries entries, either untagged (every context switch
+   flushes it) or tagged with asids address-space IDs handed out to
+   processes as they run.  A flush just starts a new generation */
+typedef struct tlbcache {
+  tlb_t *entries;
+  int asids;                /* 0 = untagged */
+  int pid;                  /* running process */
+  int asid;                 /* ... and its ASID */
+  int next_asid;            /* next unused ASID of this generation */
+  uint32_t generation;
+  int *pid_asid;            /* ASID of each pid ... */
+  uint32_t *pid_gen;        /* ... valid if assigned in this generation */
+  uint64_t tick;            /* use clock for LRU within a set */
+  uint64_t lookups;
+  uint64_t hits;
+  uint64_t huge_hits;       /* hits on huge page entries */
+  uint64_t flushes;         /* generations started */
+} tlbcache_t;
+
+
+/* inverted page table entry: one per frame, chained by hash of (pid, page) */
+typedef struct ipt_entry {
+  ptentry_t pte;
+  int pid;                      /* owner, -1 if the frame is unmapped */
+  int next;                     /* next frame in the hash chain, -1 at the end */
+} ipt_entry_t;
+
+
+/* an aligned region of 2^huge_order pages, kept after the entries of the
+   radix page table leaf holding it.  Its first fault reserves an aligned
+   block of free frames; its pages fault into the block at their offset
+   until enough are resident to promote the region to a huge page */
+typedef struct huge_region {
+  ptentry_t *first;             /* entry of the region's first page */
+  int pid;
+  int resident;                 /* resident base pages */
+  int block;                    /* first frame of the reserved block, -1 if none */
+  int huge;                     /* promoted: mapped as one huge page */
+  struct huge_region *next;     /* reservations not yet promoted, oldest first */
+  struct huge_region *prev;
+} huge_region_t;
+
+
 /* need a process structure */
-typedef struct task {                                            // task_t processes[MAX_PROCESSES];
+typedef struct task {                                            // task_t processes[max_processes];
   int pid;      //index                /* process id */
-  ptentry_t *pagetable;         /* process page table */
-  int ct;                       /* memory reference count */ // # times table is accessed
+  int created;                  /* seen in the trace */
+  void **pagetable;             /* root of the process's radix page table */
+  uint64_t ct;                  /* memory reference count */ // # times table is accessed
+  uint64_t pfs;                 /* page faults */
+  int frames;                   /* frames holding its pages */
+  int quota;                    /* frames it may hold, under local replacement ... */
+  void *repl;                   /* ... with its own replacement mechanism state */
+  uint64_t ct_mark;             /* ct and pfs at the last quota adjustment */
+  uint64_t pfs_mark;
 } task_t;
 
 
-/* need a store for all processes */
-task_t processes[MAX_PROCESSES];
+/* binary trace format: a header followed by fixed-width records */
+#define TRACE_MAGIC      0x52543250   /* "P2TR" */
+#define TRACE_VERSION    1
+#define TRACE_HAS_TIME   0x1          /* each record is followed by a uint64_t timestamp */
+
+typedef struct trace_header {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t flags;
+  uint32_t recsize;  /* bytes per record, including the optional timestamp */
+  uint64_t count;    /* number of records */
+  uint32_t page_size; /* page size the ops were derived at (converted text), 0 if unknown */
+  uint32_t reserved;
+} trace_header_t;
+
+typedef struct trace_rec {
+  uint64_t vaddr;
+  uint32_t pid;
+  uint32_t op;       /* 0=read 1=write */
+} trace_rec_t;
+
+
+#define TRACE_BUFSIZE    0x10000      /* read buffer for streamed traces */
+
+/* an open trace: binary trace files are mmap'd, everything else is streamed */
+typedef struct trace {
+  int fd;
+  int binary;
+  int seekable;               /* regular file -- can be rewound for lookahead */
+  int eof;                    /* streamed traces: no more to read */
+  unsigned int flags;
+  unsigned int recsize;
+  uint64_t count;             /* from the header, checked against the file; 0 if unknown */
+  unsigned char *map;         /* mapped binary traces */
+  size_t maplen;
+  int mem;                    /* records already in memory (trace_load, trace_view) */
+  unsigned char *buf;         /* streamed traces */
+  const unsigned char *start; /* first record */
+  const unsigned char *cur;   /* next record */
+  const unsigned char *end;
+} trace_t;
+
+
+/* event log levels */
+#define LOG_OFF          0
+#define LOG_FAULTS       1            /* faults, allocation, replacement */
+#define LOG_FULL         2            /* ... plus every access and lookup */
+
+/* event types -- vaddr is a page number for page-level events */
+#define EV_ACCESS        1            /* vaddr, arg = op */
+#define EV_TLB_HIT       2            /* vaddr, frame */
+#define EV_TLB_MISS      3            /* vaddr */
+#define EV_PT_HIT        4            /* vaddr, frame */
+#define EV_PAGE_FAULT    5            /* vaddr */
+#define EV_FREE_FRAME    6            /* vaddr, frame */
+#define EV_REPLACE       7            /* vaddr, victim frame */
+#define EV_MAP           8            /* vaddr, frame */
+#define EV_INVALIDATE    9            /* page, frame */
+#define EV_ALLOC         10           /* page, frame */
+#define EV_VICTIM        11           /* page, frame chosen by the policy */
+#define EV_PROMOTE       12           /* first page of region, first frame */
+#define EV_DEMOTE        13           /* first page of region, first frame */
+#define EV_SUSPEND       14           /* arg = pages swapped out */
+#define EV_RESUME        15           /* arg = references held */
+#define EV_CLEAN         16           /* page, frame written back; arg = batch size */
+#define EV_PREFETCH      17           /* page, frame read ahead; arg = replaced pid or -1 */
+
+#define EVENT_MAGIC      0x56453250   /* "P2EV" */
+#define EVENT_VERSION    2
+#define EVENT_RING       4096         /* events per batch written to the log */
+
+typedef struct event_header {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t recsize;
+  uint32_t reserved;
+} event_header_t;
+
+typedef struct event {
+  uint64_t seq;      /* reference number, on the machine logging the event */
+  uint64_t vaddr;
+  int32_t pid;
+  int32_t frame;
+  uint32_t type;
+  int32_t arg;
+  int32_t mech;      /* replacement mechanism of that machine */
+  uint32_t reserved;
+} event_t;
+
+extern int log_level;
+
+/* build with -DNO_EVENT_LOG (make EXTRA=-DNO_EVENT_LOG) to compile the
+   event calls out entirely */
+#ifdef NO_EVENT_LOG
+#define EVENT( level, type, pid, vaddr, frame, arg )  do { } while ( 0 )
+#else
+#define EVENT( level, type, pid, vaddr, frame, arg )			\
+  do {									\
+    if (( level ) <= log_level )					\
+      event_log(( type ), ( pid ), ( vaddr ), ( frame ), ( arg ));	\
+  } while ( 0 )
+#endif
+
+
+/* memory geometry - cmsc312-p2-config.c */
+extern int page_size;
+extern int page_shift;
+extern unsigned int page_mask;
+extern int va_bits;
+extern int pt_levels;
+extern int pt_mode;
+extern int huge_pages;
+extern int huge_order;
+extern int huge_promote;
+extern int pt_level_bits[PT_MAX_LEVELS];   /* index bits of each level, root first */
+extern int pt_level_shift[PT_MAX_LEVELS];  /* shift of a page number to each level's index */
+extern int physical_frames;
+extern int max_processes;
+extern int tlb_entries;
+extern int tlb_ways;
+extern int tlb_replacement;
+extern int tlb_asids;
+extern int tlb_tagged;
+extern int ws_window;
+extern int load_control;
+extern int pff_high;
+extern int pff_low;
+extern int local_quota;
+extern int clean_low;
+extern int clean_batch;
+extern int swap_batch;
+extern int swap_direct;
+extern char *swap_path;
+extern int readahead_max;
+
+
+/* frame bitmaps: one bit per frame, 64 frames per word */
+#define BITMAP_WORDS( n )       ((( n ) + 63 ) >> 6 )
+#define BITMAP_TEST( bm, i )    ((( bm )[( i ) >> 6] >> (( i ) & 63 )) & 1 )
+#define BITMAP_SET( bm, i )     (( bm )[( i ) >> 6] |= ( 1ULL << (( i ) & 63 )))
+#define BITMAP_CLEAR( bm, i )   (( bm )[( i ) >> 6] &= ~( 1ULL << (( i ) & 63 )))
+
+
+/* fixed-capacity node pool - cmsc312-p2-pool.c */
+typedef struct pool {
+  size_t size;                 /* bytes per node */
+  int capacity;
+  int used;                    /* nodes handed out from the slab so far */
+  unsigned char *base;         /* contiguous slab of capacity nodes */
+  void *free;                  /* recycled nodes */
+} pool_t;
+
+
+/* frequency buckets for count-based replacement - cmsc312-p2-freq.c */
+typedef struct freq_node {
+  int pid;
+  ptentry_t *ptentry;
+  struct freq_bucket *bucket;
+  struct freq_node *next;
+  struct freq_node *prev;
+} freq_node_t;
+
+typedef struct freq_bucket {
+  int count;                   /* access count shared by every node here */
+  freq_node_t *first;          /* oldest at this count */
+  freq_node_t *last;
+  struct freq_bucket *next;    /* next higher count */
+  struct freq_bucket *prev;
+} freq_bucket_t;
+
+typedef struct freq {
+  freq_bucket_t *lowest;
+  freq_bucket_t *highest;
+  freq_node_t **frames;        /* node for each frame number */
+  pool_t *nodes;               /* one node per frame */
+  pool_t *buckets;             /* at most one bucket per node, plus one */
+  int shared;                  /* frames and pools are another set's */
+} freq_t;
+
+
+/* index lists and the page directory for the adaptive replacement
+   algorithms - cmsc312-p2-qlist.c.  A qlist is a doubly linked list of
+   small integers (frame numbers or directory entries) linked through
+   arrays indexed by them, so an integer can sit on several lists at once
+   and every operation is O(1).  The head is the most recent end */
+#define QLIST_NONE       -1
+#define QLIST_OFF        -2           /* prev of an integer not on the list */
+#define QDIR_MIN         64           /* entries a process's directory starts with
+					 under local replacement */
+
+typedef struct qlist {
+  int *prev;
+  int *next;
+  int head;
+  int tail;
+  int len;
+} qlist_t;
+
+/* a directory of pages, hashed on (pid, page), for pages that are not
+   resident (ghosts) or that need state beyond their frame */
+typedef struct qdir {
+  vpn_t *page;
+  int *pid;
+  int *chain;                  /* next entry in the hash chain */
+  int *bucket;                 /* first entry of each chain */
+  unsigned int mask;
+  int *free;                   /* stack of unused entries */
+  int nfree;
+  int n;                       /* entries */
+} qdir_t;
+
+
+/* a reference held back while its process is suspended */
+typedef struct ws_ref {
+  vaddr_t vaddr;
+  int op;
+} ws_ref_t;
+
+
+/* working set of a process: the pages of its last ws_window references
+   -- see cmsc312-p2-ws.c */
+typedef struct wset {
+  qdir_t dir;                   /* pages in the window */
+  int *ring;                    /* entry of each of the last ws_window references */
+  uint64_t *last;               /* process time of each entry's last reference */
+  int size;                     /* pages in the window */
+  int peak;
+  uint64_t sum;                 /* size summed over references, for the mean */
+  uint64_t pfs;                 /* page faults */
+  int faults;                   /* ... since the last load control check */
+  uint64_t seen;                /* arrival clock at its last reference run */
+  int suspended;
+  uint64_t since;               /* arrival clock when suspended */
+  int suspensions;
+  ws_ref_t *held;               /* references held while suspended */
+  int nheld;
+  int maxheld;
+  qlist_t resident;             /* its frames, linked through sim->ws_frames */
+} wset_t;
+
+
+/* the page cleaner: a hand sweeping the frames for dirty pages not
+   referenced since it last passed -- see cmsc312-p2-clean.c */
+typedef struct cleaner {
+  uint64_t *seen;               /* frames referenced since the hand passed */
+  uint64_t *cleaned;            /* frames whose page the cleaner wrote back */
+  int hand;
+  frame_t **batch;              /* the pages of a write-back */
+} cleaner_t;
+
+
+/* the swap file: frames hold real page contents, and a page written
+   out has a slot in the file -- see cmsc312-p2-swap.c */
+typedef struct swapdev {
+  int fd;
+  char *path;
+  char *data;                   /* contents of each frame */
+  qdir_t dir;                   /* pages with a copy in a slot ... */
+  int *slot;                    /* ... the slot of each ... */
+  uint64_t *stamp;              /* ... and the count of writes its copy holds */
+  uint64_t *used;               /* a set bit is a slot in use */
+  int slots;                    /* slots the bitmap covers */
+  int in_use;
+  int peak;
+  int cursor;                   /* next fit: free slots are looked for from here */
+  int next;                     /* slot after the last write */
+  char *queue;                  /* evicted pages waiting to be written together ... */
+  int *queued;                  /* ... their entries (QLIST_NONE: dirtied since) */
+  int nqueued;
+  int qslot;                    /* first slot of the run reserved for them ... */
+  int qlen;                     /* ... and its length */
+  struct iovec *iov;
+
+  /* measured */
+  uint64_t writes;              /* pwritev calls ... */
+  uint64_t write_pages;         /* ... the pages in them ... */
+  uint64_t seq_writes;          /* ... and those starting where the last ended */
+  uint64_t write_ns;
+  uint64_t evict_ns;            /* write time of evicted pages (the fault path's) */
+  uint64_t reads;               /* preadv calls */
+  uint64_t read_ns;
+  uint64_t queue_hits;          /* page-ins served from the queue */
+  uint64_t fills;               /* first touches, filled without a read */
+  uint64_t mismatches;          /* pages read back that were not the page */
+} swapdev_t;
+
+
+/* readahead: each process's fault stream -- see cmsc312-p2-ahead.c */
+typedef struct ra_stream {
+  vpn_t last;                   /* page of the last fault */
+  int64_t stride;               /* pages between the last two faults */
+  vpn_t next;                   /* fault that would continue the stream */
+  int window;                   /* pages read ahead per fault; 0 = no stream */
+} ra_stream_t;
+
+typedef struct ra_state {
+  ra_stream_t *stream;          /* max_processes */
+  uint64_t *ahead;              /* frames read ahead and not yet referenced */
+  int max;                      /* largest window on this machine */
+} ra_state_t;
+
 
+/* one simulated machine: the state a run updates, so that several can
+   run side by side over the same trace.  The running thread's machine
+   is sim */
+typedef struct sim {
+  int mech;                     /* replacement mechanism */
+  int frames;                   /* physical frames */
+  int tlb_entries;              /* TLB entries ... */
+  int tlb_ways;                 /* ... in sets of tlb_ways */
+  unsigned int tlb_set_mask;    /* sets - 1 */
+  task_t *processes;            /* max_processes */
+  frame_t *physical_mem;        /* frames */
+  uint64_t *free_frames;        /* a set bit is a free frame ... */
+  int free_words;
+  int free_hint;                /* ... words below free_hint are full */
+  int current_pid;
+  int fault_pid;                /* page being faulted in when a victim is */
+  vpn_t fault_page;             /* chosen, for policies that adapt (arc) */
+  tlbcache_t tlb;               /* the simulated TLB */
+  tlbcache_t tlb_shadow;        /* untagged, for comparison with a tagged tlb */
+  void *repl;                   /* replacement mechanism state */
+  void *repl_model;             /* local replacement: the state made at init, which
+				   later states may share read-only state with (opt) */
+  int repl_pid;                 /* ... and the process whose state sim->repl is */
+  trace_t *trace;               /* the trace the mechanism was initialized on */
 
-extern frame_t physical_mem[PHYSICAL_FRAMES];
-extern ptentry_t *current_pt;
+  /* inverted page table - cmsc312-p2-ipt.c */
+  ipt_entry_t *ipt;
+  int *ipt_anchor;
+  unsigned int ipt_mask;
+
+  /* huge page reservations not yet promoted, oldest first */
+  huge_region_t *resv_head;
+  huge_region_t *resv_tail;
+
+  /* working sets and load control - cmsc312-p2-ws.c */
+  wset_t *ws;                   /* max_processes, NULL if not tracked */
+  uint64_t ws_clock;            /* references arrived, held ones included */
+  int ws_refs;                  /* references run since the last check ... */
+  int ws_faults;                /* ... and the faults among them */
+  qlist_t ws_frames;            /* links of the processes' resident lists (load control) */
+  qlist_t ws_active;            /* processes that ran lately, not suspended */
+  qlist_t ws_suspended;         /* suspended processes, longest suspended first */
+
+  /* local replacement - cmsc312-p2-local.c */
+  int *local_heap;              /* processes holding frames, furthest over quota first ... */
+  int *local_pos;               /* ... and each one's place in it (-1 if none) */
+  int local_count;
+  uint64_t *local_weight;       /* scratch for splitting the frames */
+
+  /* page cleaner - cmsc312-p2-clean.c */
+  cleaner_t *clean;             /* NULL if no cleaner */
+  int dirty;                    /* resident pages that are dirty */
+
+  /* swap file - cmsc312-p2-swap.c */
+  swapdev_t *swap;              /* NULL if swapping is only modeled */
+
+  /* readahead - cmsc312-p2-ahead.c */
+  ra_state_t *ra;               /* NULL if pages are only read on demand */
+  struct sim *ra_base;          /* the machine without readahead, for comparison */
+  int prefetching;              /* a page being read ahead is not the one
+				   referenced (for opt) */
+
+  /* stats */
+  uint64_t swaps;               /* swaps to disk */
+  uint64_t invalidates;         /* reassign page w/o swap */
+  uint64_t pfs;                 /* all page faults */
+  uint64_t memory_accesses;     /* accesses that miss TLB but hit memory */
+  uint64_t total_accesses;      /* all accesses */
+  uint64_t free_allocs;         /* faults served from a free frame */
+  uint64_t replace_allocs;      /* faults that ran page replacement */
+  uint64_t switches;            /* context switches */
+  uint64_t pt_walks;            /* page table walks (TLB misses) */
+  uint64_t pt_walk_levels;      /* page table levels read by the walks */
+  int pt_nodes;                 /* radix page table nodes allocated */
+  uint64_t pt_bytes;            /* ... and their size */
+  uint64_t huge_promotions;     /* regions promoted to huge pages */
+  uint64_t huge_prefilled;      /* base pages read in by promotions */
+  uint64_t huge_demotions;      /* huge pages split by an eviction */
+  uint64_t huge_breaks;         /* reservations given up before promotion */
+  int ws_peak_demand;           /* largest total of the running working sets */
+  uint64_t ws_overloads;        /* checks that found memory overcommitted */
+  uint64_t ws_suspensions;      /* processes suspended ... */
+  uint64_t ws_swapped;          /* ... and the pages swapped out with them */
+  uint64_t ws_held;             /* references held back */
+  uint64_t ws_full;             /* resumptions forced by a full hold */
+  uint64_t clean_wakes;         /* times the cleaner found too few clean frames */
+  uint64_t clean_batches;       /* write-backs it issued ... */
+  uint64_t clean_pages;         /* ... and the pages in them */
+  uint64_t clean_avoided;       /* evictions of cleaned pages that needed no write */
+  uint64_t clean_redirtied;     /* cleaned pages written again before eviction */
+  uint64_t ra_streams;          /* streams detected */
+  uint64_t ra_windows;          /* faults that read ahead ... */
+  uint64_t ra_pages;            /* ... and the pages read */
+  uint64_t ra_hits;             /* pages read ahead, then referenced */
+  uint64_t ra_misses;           /* ... or evicted unreferenced */
+} sim_t;
+
+extern __thread sim_t *sim;
+extern char *pt_mech_names[];
 
 
 /* initialization */
-extern int page_replacement_init( FILE *fp, int mech );
+extern int page_replacement_init( trace_t *tr, int mech );
+extern sim_t *sim_create( trace_t *tr, int mech, int frames, int entries );
+extern void sim_destroy( sim_t *s );
+extern int sim_access( int pid, vaddr_t vaddr, int op );
+extern int sim_step( int pid, vaddr_t vaddr, int op );
+extern int sim_finish( void );
+extern void sim_times( float *tlb_hit_ratio, float *walk, float *mem_access_time,
+		       float *pf_ratio, float *access_time );
 
 /* process (task) functions */
 extern int process_create( int pid );
 extern int process_frames( int pid, int *frames );
 
-/* TLB functions */
-extern int tlb_resolve_addr( unsigned int vaddr, unsigned int *paddr, int op );
-extern int tlb_update_pageref( int frame, int page, int op );
+/* TLB functions - cmsc312-p2-tlb.c */
+extern int tlb_init( void );
+extern void tlb_exit( void );
+extern int tlb_switch( int pid );
+extern int tlb_resolve_addr( vaddr_t vaddr, uint64_t *paddr, int op );
+extern int tlb_update_pageref( ptentry_t *ptentry, int op );
 extern int tlb_flush( void );
+extern int tlb_invalidate_page( int pid, vpn_t page );
+extern int tlb_invalidate_huge( int pid, vpn_t page );
+extern uint64_t tlb_reach( tlbcache_t *tc );
 
 /* page table functions */
-extern int pt_resolve_addr( unsigned int vaddr, unsigned int *paddr, int *valid, int op );
-extern int pt_demand_page( int pid, unsigned int vaddr, unsigned int *paddr, int op, int mech );
+extern ptentry_t *pt_lookup( int pid, vpn_t page, int create, int *levels );
+extern int pt_resolve_addr( vaddr_t vaddr, uint64_t *paddr, int *valid, int op );
+extern int pt_demand_page( int pid, vaddr_t vaddr, uint64_t *paddr, int op, int mech );
+extern int pt_prefetch_page( int pid, vpn_t page, int mech );
 extern int pt_write_frame( frame_t *frame );
 extern int pt_alloc_frame( int pid, frame_t *f, ptentry_t *ptentry, int op, int mech );
-extern int pt_invalidate_mapping( int pid, int page );
+extern int pt_invalidate_mapping( int pid, vpn_t page );
+extern int pt_count_ref( int pid, ptentry_t *ptentry );
+extern int pt_find_free_frame( void );
+extern int pt_free_frame( frame_t *f );
+extern int pt_swap_out( int pid, frame_t *f );
+extern int pt_replacement_of( int pid );
 
 /* external functions */
-extern int get_memory_access( FILE *fp, int *pid, unsigned int *vaddr, int *op, int *eof );
+extern int get_memory_access( trace_t *tr, int *pid, vaddr_t *vaddr, int *op, int *eof );
 extern int context_switch( int pid );
 extern int hw_update_pageref( ptentry_t *ptentry, int op );
 extern int write_results( FILE *out );
+extern int write_compare( FILE *out, sim_t **sims, int n );
+
+/* traces - cmsc312-p2-trace.c */
+extern trace_t *trace_open( char *path );
+extern int trace_rewind( trace_t *tr );
+extern int trace_next( trace_t *tr, int *pid, vaddr_t *vaddr, int *op );
+extern int trace_close( trace_t *tr );
+extern trace_t *trace_load( trace_t *tr );
+extern trace_t *trace_view( trace_t *tr );
+extern int trace_text_op( vaddr_t vaddr );
+extern FILE *trace_create( char *path, unsigned int flags );
+extern int trace_append( FILE *fp, unsigned int flags, int pid, uint64_t vaddr, int op, uint64_t time );
+extern int trace_finish( FILE *fp, uint64_t count );
+
+/* huge pages - cmsc312-p2-huge.c */
+extern size_t huge_leaf_extra( int entries );
+extern void huge_leaf_init( ptentry_t *leaf, int entries );
+extern huge_region_t *huge_region( ptentry_t *ptentry );
+extern int huge_frame( int pid, ptentry_t *ptentry );
+extern int huge_break_oldest( void );
+extern int huge_mapped( ptentry_t *ptentry );
+extern int huge_unmapped( ptentry_t *ptentry );
+extern int huge_check_promote( ptentry_t *ptentry, int mech );
+
+/* inverted page table - cmsc312-p2-ipt.c */
+extern int ipt_init( void );
+extern void ipt_exit( void );
+extern uint64_t ipt_bytes( void );
+extern ptentry_t *ipt_lookup( int pid, vpn_t page, int *probes );
+extern ptentry_t *ipt_insert( int pid, vpn_t page, int frame );
+extern int ipt_remove( int frame );
+
+/* configuration - cmsc312-p2-config.c */
+extern int config_set( const char *name, const char *value );
+extern int config_load( const char *path );
+extern int config_check( void );
+extern int config_tlb( int entries, int *ways, unsigned int *set_mask );
+
+/* parameter sweeps - cmsc312-p2-sweep.c */
+extern int sweep_list( const char *arg, int **vals );
+extern int sweep_run( trace_t *tr, int *mechs, int nmechs, int *frames, int nframes,
+		      int *entries, int nentries, int threads, FILE *out );
+
+/* miss-ratio curves - cmsc312-p2-stack.c */
+extern int stack_curve( trace_t *tr, FILE *out );
+
+/* working sets and load control - cmsc312-p2-ws.c */
+extern int ws_init( void );
+extern void ws_exit( void );
+extern int ws_access( int pid, vaddr_t vaddr, int op );
+extern int ws_ref( int pid, vpn_t page );
+extern int ws_finish( void );
+extern void ws_frame_taken( frame_t *f );
+extern void ws_frame_freed( frame_t *f );
+extern void ws_write( FILE *out );
+
+/* local replacement - cmsc312-p2-local.c */
+extern int local_init( void );
+extern void local_exit( void );
+extern void local_moved( int pid );
+extern void local_rebalance( void );
+extern void local_adjust( void );
+extern int local_full( int pid );
+extern int local_frames( void );
+extern int local_owner( int pid );
+extern const char *local_mode( void );
+
+/* page cleaner - cmsc312-p2-clean.c */
+extern int clean_init( void );
+extern void clean_exit( void );
+extern void clean_ref( int frame );
+extern int clean_wake( void );
+extern void clean_evicted( int frame, int dirty );
+extern float clean_stall( void );
+extern void clean_write( FILE *out );
+
+/* swap file - cmsc312-p2-swap.c */
+extern int swap_init( void );
+extern void swap_exit( void );
+extern int swap_in( frame_t *f );
+extern int swap_out( frame_t *f );
+extern int swap_clean( frame_t **f, int n );
+extern void swap_stamp( int frame );
+extern void swap_dirtied( frame_t *f );
+extern int swap_flush( void );
+extern void swap_write( FILE *out );
+
+/* readahead - cmsc312-p2-ahead.c */
+extern int ra_init( void );
+extern void ra_exit( void );
+extern int ra_fault( int pid, vpn_t page, int mech );
+extern void ra_ref( int frame );
+extern void ra_evicted( int frame );
+extern void ra_write( FILE *out );
+
+/* event log - cmsc312-p2-event.c */
+extern int event_open( char *path, int level );
+extern int event_log( int type, int pid, uint64_t vaddr, int frame, int arg );
+extern int event_flush( void );
+extern int event_close( void );
+
+
+/* node pool - cmsc312-p2-pool.c */
+extern pool_t *pool_create( size_t size, int capacity );
+extern void *pool_alloc( pool_t *pool );
+extern void pool_free( pool_t *pool, void *p );
+extern void pool_destroy( pool_t *pool );
+
+/* index lists and page directory - cmsc312-p2-qlist.c */
+extern int qlist_init( qlist_t *q, int n );
+extern void qlist_share( qlist_t *q, qlist_t *from );
+extern int qlist_grow( qlist_t *q, int n, int more );
+extern void qlist_free( qlist_t *q );
+extern void qlist_push( qlist_t *q, int i );
+extern void qlist_append( qlist_t *q, int i );
+extern void qlist_insert( qlist_t *q, int i, int after );
+extern void qlist_remove( qlist_t *q, int i );
+#define qlist_on( q, i )        ((q)->prev[i] != QLIST_OFF )
+extern int qdir_init( qdir_t *d, int n );
+extern void qdir_free( qdir_t *d );
+extern int qdir_find( qdir_t *d, int pid, vpn_t page );
+extern int qdir_add( qdir_t *d, int pid, vpn_t page );
+extern int qdir_grow( qdir_t *d );
+extern int qdir_room( qdir_t *d, qlist_t **lists, int n );
+extern void qdir_del( qdir_t *d, int i );
+extern int qdir_ghost( qdir_t *d, qlist_t *q, int pid, vpn_t page );
+extern void qdir_drop( qdir_t *d, qlist_t *q );
+
+/* frequency buckets - cmsc312-p2-freq.c */
+extern freq_t *freq_create( int frames );
+extern freq_t *freq_share( freq_t *from );
+extern void freq_destroy( freq_t *fq );
+extern int freq_insert( freq_t *fq, int pid, ptentry_t *ptentry, int frame );
+extern int freq_touch( freq_t *fq, int frame );
+extern int freq_remove( freq_t *fq, int frame );
+extern freq_node_t *freq_min( freq_t *fq );
+extern freq_node_t *freq_max( freq_t *fq );
 
 
 /* mfu - cmsc312-p2-mfu.c */
-extern int init_mfu( FILE *fp );
+extern int init_mfu( trace_t *tr );
+extern void exit_mfu( void );
 extern int replace_mfu( int *pid, frame_t **victim );
 extern int update_mfu( int pid, frame_t *f );
+extern int ref_mfu( int pid, frame_t *f );
+extern int release_mfu( int pid, frame_t *f );
 
 /* second - cmsc312-p2-second.c */
-extern int init_second( FILE *fp );
+extern int init_second( trace_t *tr );
+extern void exit_second( void );
 extern int replace_second( int *pid, frame_t **victim );
 extern int update_second( int pid, frame_t *f );
+extern int ref_second( int pid, frame_t *f );
+extern int release_second( int pid, frame_t *f );
 
 /* lfu - cmsc312-p2-lfu.c */
-extern int init_lfu( FILE *fp );
+extern int init_lfu( trace_t *tr );
+extern void exit_lfu( void );
 extern int replace_lfu( int *pid, frame_t **victim );
 extern int update_lfu( int pid, frame_t *f );
+extern int ref_lfu( int pid, frame_t *f );
+extern int release_lfu( int pid, frame_t *f );
+
+/* opt - cmsc312-p2-opt.c */
+extern int init_opt( trace_t *tr );
+extern void exit_opt( void );
+extern int replace_opt( int *pid, frame_t **victim );
+extern int update_opt( int pid, frame_t *f );
+extern int ref_opt( int pid, frame_t *f );
+extern int release_opt( int pid, frame_t *f );
+
+/* lru - cmsc312-p2-lru.c */
+extern int init_lru( trace_t *tr );
+extern void exit_lru( void );
+extern int replace_lru( int *pid, frame_t **victim );
+extern int update_lru( int pid, frame_t *f );
+extern int ref_lru( int pid, frame_t *f );
+extern int release_lru( int pid, frame_t *f );
+
+/* arc - cmsc312-p2-arc.c */
+extern int init_arc( trace_t *tr );
+extern void exit_arc( void );
+extern int replace_arc( int *pid, frame_t **victim );
+extern int update_arc( int pid, frame_t *f );
+extern int ref_arc( int pid, frame_t *f );
+extern int release_arc( int pid, frame_t *f );
+
+/* car - cmsc312-p2-car.c */
+extern int init_car( trace_t *tr );
+extern void exit_car( void );
+extern int replace_car( int *pid, frame_t **victim );
+extern int update_car( int pid, frame_t *f );
+extern int ref_car( int pid, frame_t *f );
+extern int release_car( int pid, frame_t *f );
+
+/* 2q - cmsc312-p2-2q.c */
+extern int init_2q( trace_t *tr );
+extern void exit_2q( void );
+extern int replace_2q( int *pid, frame_t **victim );
+extern int update_2q( int pid, frame_t *f );
+extern int ref_2q( int pid, frame_t *f );
+extern int release_2q( int pid, frame_t *f );
+
+/* lirs - cmsc312-p2-lirs.c */
+extern int init_lirs( trace_t *tr );
+extern void exit_lirs( void );
+extern int replace_lirs( int *pid, frame_t **victim );
+extern int update_lirs( int pid, frame_t *f );
+extern int ref_lirs( int pid, frame_t *f );
+extern int release_lirs( int pid, frame_t *f );